@@ -1 +1,583 @@
- 
\ No newline at end of file
+/**
+ * Author: bbbyk
+ * Time: 2019.11
+ *
+ * Realize the allocator.
+ * Two levels like SGI STL:
+ *   first level  -- malloc_alloc, a thin wrapper of malloc/free with an
+ *                   out-of-memory handler.
+ *   second level -- default_alloc, free lists of small blocks (<= 128
+ *                   bytes) carved from big chunks; bigger requests go to
+ *                   the first level.
+ * And a per-thread variant, thread_alloc, whose free lists and chunk
+ * belong to one thread, so allocate/deallocate take no lock at all.
+ * **/
+
+#ifndef MTL_ALLOC_H
+#define MTL_ALLOC_H
+
+#include <cstddef>  // size_t, ptrdiff_t
+#include <cstdlib>  // malloc, free, realloc
+#include <cstring>  // memcpy
+#include <new>      // bad_alloc, placement new
+#include <mutex>
+
+namespace mtl
+{
+
+/**
+ * first level allocator
+ * when malloc fails, call the handler set by the user and try again.
+ * if there is no handler, throw bad_alloc.
+ * **/
+template <int inst>
+class malloc_alloc_template
+{
+private:
+    typedef void (*handler_type)();
+    static handler_type oom_handler;
+
+    static void* oom_malloc(size_t n);
+    static void* oom_realloc(void* p, size_t n);
+
+public:
+    static void* allocate(size_t n)
+    {
+        void* result = malloc(n);
+        if (0 == result) result = oom_malloc(n);
+        return result;
+    }
+
+    static void deallocate(void* p, size_t /* n */)
+    {
+        free(p);
+    }
+
+    static void* reallocate(void* p, size_t /* old_sz */, size_t new_sz)
+    {
+        void* result = realloc(p, new_sz);
+        if (0 == result) result = oom_realloc(p, new_sz);
+        return result;
+    }
+
+    // like std::set_new_handler, return the old one
+    static handler_type set_malloc_handler(handler_type f)
+    {
+        handler_type old = oom_handler;
+        oom_handler = f;
+        return old;
+    }
+};
+
+template <int inst>
+typename malloc_alloc_template<inst>::handler_type
+malloc_alloc_template<inst>::oom_handler = 0;
+
+template <int inst>
+void* malloc_alloc_template<inst>::oom_malloc(size_t n)
+{
+    for (;;) {
+        handler_type handler = oom_handler;
+        if (0 == handler) throw std::bad_alloc();
+        handler();   // the handler should free some memory
+        void* result = malloc(n);
+        if (result) return result;
+    }
+}
+
+template <int inst>
+void* malloc_alloc_template<inst>::oom_realloc(void* p, size_t n)
+{
+    for (;;) {
+        handler_type handler = oom_handler;
+        if (0 == handler) throw std::bad_alloc();
+        handler();
+        void* result = realloc(p, n);
+        if (result) return result;
+    }
+}
+
+typedef malloc_alloc_template<0> malloc_alloc;
+
+/**
+ * the size classes shared by the second level and the per-thread pool.
+ * every block is rounded up to a multiple of 8, so a block of one pool
+ * can be put on the free list of the other pool with the same size.
+ * **/
+enum { ALIGN = 8 };
+enum { MAX_BYTES = 128 };
+enum { NFREELISTS = MAX_BYTES / ALIGN };
+
+// a free block keeps the pointer to the next free block in itself
+union free_obj {
+    union free_obj* next;
+    char data[1];
+};
+
+inline size_t round_up(size_t bytes)
+{
+    return (bytes + ALIGN - 1) & ~((size_t)ALIGN - 1);
+}
+
+inline size_t freelist_index(size_t bytes)
+{
+    return (bytes + ALIGN - 1) / ALIGN - 1;
+}
+
+// cut a chunk of nobjs blocks of size n into a list,
+// the first block is kept by the caller.
+inline free_obj* link_chunk(char* chunk, size_t n, int nobjs)
+{
+    free_obj* head = (free_obj*)(chunk + n);
+    free_obj* cur = head;
+    for (int i = 1; i < nobjs - 1; i++) {
+        free_obj* next = (free_obj*)((char*)cur + n);
+        cur->next = next;
+        cur = next;
+    }
+    cur->next = 0;
+    return head;
+}
+
+/**
+ * second level allocator
+ * threads: whether a mutex protects the pool.
+ * inst: only to get different pools.
+ * **/
+template <bool threads, int inst>
+class default_alloc_template
+{
+private:
+    static free_obj* volatile free_list[NFREELISTS];
+
+    // the chunk we are cutting now
+    static char* start_free;
+    static char* end_free;
+    static size_t heap_size;
+
+    static std::mutex pool_mutex;
+
+    // lock the pool only if threads is true
+    class lock
+    {
+    public:
+        lock() { if (threads) pool_mutex.lock(); }
+        ~lock() { if (threads) pool_mutex.unlock(); }
+    };
+
+    static void* refill(size_t n);
+
+public:
+    // get nobjs blocks of size n from the pool, nobjs may be reduced
+    static char* chunk_alloc(size_t size, int& nobjs);
+
+    static void* allocate(size_t n)
+    {
+        if (n > (size_t)MAX_BYTES)
+            return malloc_alloc::allocate(n);
+
+        free_obj* volatile* my_free_list = free_list + freelist_index(n);
+        lock guard;
+        free_obj* result = *my_free_list;
+        if (0 == result)
+            return refill(round_up(n));
+        *my_free_list = result->next;
+        return result;
+    }
+
+    static void deallocate(void* p, size_t n)
+    {
+        if (n > (size_t)MAX_BYTES) {
+            malloc_alloc::deallocate(p, n);
+            return;
+        }
+
+        free_obj* volatile* my_free_list = free_list + freelist_index(n);
+        free_obj* q = (free_obj*)p;
+        lock guard;
+        q->next = *my_free_list;
+        *my_free_list = q;
+    }
+
+    static void* reallocate(void* p, size_t old_sz, size_t new_sz);
+};
+
+template <bool threads, int inst>
+free_obj* volatile default_alloc_template<threads, inst>::free_list[NFREELISTS] = { 0 };
+
+template <bool threads, int inst>
+char* default_alloc_template<threads, inst>::start_free = 0;
+
+template <bool threads, int inst>
+char* default_alloc_template<threads, inst>::end_free = 0;
+
+template <bool threads, int inst>
+size_t default_alloc_template<threads, inst>::heap_size = 0;
+
+template <bool threads, int inst>
+std::mutex default_alloc_template<threads, inst>::pool_mutex;
+
+// we hold the lock
+template <bool threads, int inst>
+void* default_alloc_template<threads, inst>::refill(size_t n)
+{
+    int nobjs = 20;
+    char* chunk = chunk_alloc(n, nobjs);
+    if (1 == nobjs) return chunk;
+    free_list[freelist_index(n)] = link_chunk(chunk, n, nobjs);
+    return chunk;
+}
+
+// we hold the lock when threads is true
+template <bool threads, int inst>
+char* default_alloc_template<threads, inst>::chunk_alloc(size_t size, int& nobjs)
+{
+    size_t total_bytes = size * nobjs;
+    size_t bytes_left = end_free - start_free;
+
+    // the chunk is enough
+    if (bytes_left >= total_bytes) {
+        char* result = start_free;
+        start_free += total_bytes;
+        return result;
+    }
+    // at least one block
+    if (bytes_left >= size) {
+        nobjs = (int)(bytes_left / size);
+        total_bytes = size * nobjs;
+        char* result = start_free;
+        start_free += total_bytes;
+        return result;
+    }
+
+    // put the left-over piece on the free list of its size
+    if (bytes_left > 0) {
+        free_obj* volatile* my_free_list = free_list + freelist_index(bytes_left);
+        ((free_obj*)start_free)->next = *my_free_list;
+        *my_free_list = (free_obj*)start_free;
+    }
+
+    size_t bytes_to_get = 2 * total_bytes + round_up(heap_size >> 4);
+    start_free = (char*)malloc(bytes_to_get);
+    if (0 == start_free) {
+        // take a free block which is big enough from the larger lists
+        for (size_t i = size; i <= (size_t)MAX_BYTES; i += ALIGN) {
+            free_obj* volatile* my_free_list = free_list + freelist_index(i);
+            free_obj* p = *my_free_list;
+            if (0 != p) {
+                *my_free_list = p->next;
+                start_free = (char*)p;
+                end_free = start_free + i;
+                return chunk_alloc(size, nobjs);
+            }
+        }
+        end_free = 0;   // in case of exception
+        // the first level will call the handler or throw
+        start_free = (char*)malloc_alloc::allocate(bytes_to_get);
+    }
+    heap_size += bytes_to_get;
+    end_free = start_free + bytes_to_get;
+    return chunk_alloc(size, nobjs);
+}
+
+template <bool threads, int inst>
+void* default_alloc_template<threads, inst>::reallocate(void* p, size_t old_sz, size_t new_sz)
+{
+    if (old_sz > (size_t)MAX_BYTES && new_sz > (size_t)MAX_BYTES)
+        return malloc_alloc::reallocate(p, old_sz, new_sz);
+    if (round_up(old_sz) == round_up(new_sz))
+        return p;
+    void* result = allocate(new_sz);
+    memcpy(result, p, new_sz > old_sz ? old_sz : new_sz);
+    deallocate(p, old_sz);
+    return result;
+}
+
+typedef default_alloc_template<true, 0> alloc;
+typedef default_alloc_template<false, 0> single_client_alloc;
+
+/**
+ * per-thread allocator
+ * each thread has its own free lists and its own chunk, so allocate and
+ * deallocate never lock.  The chunks come straight from malloc.
+ * A block freed by another thread goes to that thread's free lists,
+ * it is fine but the memory moves to that thread.
+ * When a thread exits, its state is kept on a list and reused by the
+ * next new thread (only this takes the lock).
+ * **/
+template <int inst>
+class thread_alloc_template
+{
+private:
+    struct per_thread_state {
+        free_obj* free_list[NFREELISTS];
+        char* start_free;
+        char* end_free;
+        size_t heap_size;
+        per_thread_state* next;    // link of the list of free states
+    };
+
+    // give the state back when the thread exits
+    class state_holder
+    {
+    public:
+        per_thread_state* state;
+        state_holder() : state(0) {}
+        ~state_holder()
+        {
+            if (state) release_state(state);
+            exiting = true;
+        }
+    };
+
+    static per_thread_state* free_states;
+    static std::mutex state_mutex;
+
+    static thread_local per_thread_state* my_state;
+    static thread_local bool exiting;
+
+    static per_thread_state* new_state();
+    static void release_state(per_thread_state* s);
+    static void* refill(per_thread_state* s, size_t n);
+    static char* chunk_alloc(per_thread_state* s, size_t size, int& nobjs);
+
+    // 0 after the thread's destructors have run
+    static per_thread_state* get_state()
+    {
+        per_thread_state* s = my_state;
+        if (0 == s && !exiting) s = new_state();
+        return s;
+    }
+
+public:
+    static void* allocate(size_t n)
+    {
+        if (n > (size_t)MAX_BYTES)
+            return malloc_alloc::allocate(n);
+
+        per_thread_state* s = get_state();
+        if (0 == s) return alloc::allocate(n);
+
+        free_obj** my_free_list = s->free_list + freelist_index(n);
+        free_obj* result = *my_free_list;
+        if (0 == result)
+            return refill(s, round_up(n));
+        *my_free_list = result->next;
+        return result;
+    }
+
+    static void deallocate(void* p, size_t n)
+    {
+        if (n > (size_t)MAX_BYTES) {
+            malloc_alloc::deallocate(p, n);
+            return;
+        }
+
+        per_thread_state* s = get_state();
+        if (0 == s) {
+            // the blocks have the same sizes, the shared pool can take it
+            alloc::deallocate(p, n);
+            return;
+        }
+        free_obj** my_free_list = s->free_list + freelist_index(n);
+        free_obj* q = (free_obj*)p;
+        q->next = *my_free_list;
+        *my_free_list = q;
+    }
+
+    static void* reallocate(void* p, size_t old_sz, size_t new_sz)
+    {
+        if (old_sz > (size_t)MAX_BYTES && new_sz > (size_t)MAX_BYTES)
+            return malloc_alloc::reallocate(p, old_sz, new_sz);
+        if (round_up(old_sz) == round_up(new_sz))
+            return p;
+        void* result = allocate(new_sz);
+        memcpy(result, p, new_sz > old_sz ? old_sz : new_sz);
+        deallocate(p, old_sz);
+        return result;
+    }
+};
+
+template <int inst>
+typename thread_alloc_template<inst>::per_thread_state*
+thread_alloc_template<inst>::free_states = 0;
+
+template <int inst>
+std::mutex thread_alloc_template<inst>::state_mutex;
+
+template <int inst>
+thread_local typename thread_alloc_template<inst>::per_thread_state*
+thread_alloc_template<inst>::my_state = 0;
+
+template <int inst>
+thread_local bool thread_alloc_template<inst>::exiting = false;
+
+template <int inst>
+typename thread_alloc_template<inst>::per_thread_state*
+thread_alloc_template<inst>::new_state()
+{
+    static thread_local state_holder holder;
+    per_thread_state* s;
+    {
+        std::lock_guard<std::mutex> guard(state_mutex);
+        s = free_states;
+        if (s) free_states = s->next;
+    }
+    if (0 == s) {
+        s = (per_thread_state*)malloc_alloc::allocate(sizeof(per_thread_state));
+        memset(s, 0, sizeof(per_thread_state));
+    }
+    holder.state = s;
+    my_state = s;
+    return s;
+}
+
+template <int inst>
+void thread_alloc_template<inst>::release_state(per_thread_state* s)
+{
+    my_state = 0;
+    std::lock_guard<std::mutex> guard(state_mutex);
+    s->next = free_states;
+    free_states = s;
+}
+
+template <int inst>
+void* thread_alloc_template<inst>::refill(per_thread_state* s, size_t n)
+{
+    int nobjs = 20;
+    char* chunk = chunk_alloc(s, n, nobjs);
+    if (1 == nobjs) return chunk;
+    s->free_list[freelist_index(n)] = link_chunk(chunk, n, nobjs);
+    return chunk;
+}
+
+// same as default_alloc_template::chunk_alloc, but on the thread's chunk
+template <int inst>
+char* thread_alloc_template<inst>::chunk_alloc(per_thread_state* s, size_t size, int& nobjs)
+{
+    size_t total_bytes = size * nobjs;
+    size_t bytes_left = s->end_free - s->start_free;
+
+    if (bytes_left >= total_bytes) {
+        char* result = s->start_free;
+        s->start_free += total_bytes;
+        return result;
+    }
+    if (bytes_left >= size) {
+        nobjs = (int)(bytes_left / size);
+        total_bytes = size * nobjs;
+        char* result = s->start_free;
+        s->start_free += total_bytes;
+        return result;
+    }
+
+    if (bytes_left > 0) {
+        free_obj** my_free_list = s->free_list + freelist_index(bytes_left);
+        ((free_obj*)s->start_free)->next = *my_free_list;
+        *my_free_list = (free_obj*)s->start_free;
+    }
+
+    size_t bytes_to_get = 2 * total_bytes + round_up(s->heap_size >> 4);
+    s->end_free = 0;   // in case of exception
+    s->start_free = (char*)malloc_alloc::allocate(bytes_to_get);
+    s->heap_size += bytes_to_get;
+    s->end_free = s->start_free + bytes_to_get;
+    return chunk_alloc(s, size, nobjs);
+}
+
+typedef thread_alloc_template<0> thread_alloc;
+
+/**
+ * simple_alloc: allocate by the number of objects.
+ * containers use it with the allocators above.
+ * **/
+template <class T, class Alloc>
+class simple_alloc
+{
+public:
+    static T* allocate(size_t n)
+    {
+        return 0 == n ? 0 : (T*)Alloc::allocate(n * sizeof(T));
+    }
+    static T* allocate()
+    {
+        return (T*)Alloc::allocate(sizeof(T));
+    }
+    static void deallocate(T* p, size_t n)
+    {
+        if (0 != n) Alloc::deallocate(p, n * sizeof(T));
+    }
+    static void deallocate(T* p)
+    {
+        Alloc::deallocate(p, sizeof(T));
+    }
+};
+
+/**
+ * allocator: the standard interface on top of the allocators above,
+ * so the std containers can use them too.
+ * **/
+template <class T, class Alloc = alloc>
+class allocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef allocator<U, Alloc> other;
+    };
+
+    allocator() {}
+    allocator(const allocator&) {}
+    template <class U>
+    allocator(const allocator<U, Alloc>&) {}
+
+    pointer allocate(size_type n, const void* = 0)
+    {
+        return simple_alloc<T, Alloc>::allocate(n);
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        simple_alloc<T, Alloc>::deallocate(p, n);
+    }
+
+    void construct(pointer p, const T& value)
+    {
+        new(p) T(value);
+    }
+
+    void destroy(pointer p)
+    {
+        p->~T();
+    }
+
+    pointer address(reference x) const { return &x; }
+    const_pointer address(const_reference x) const { return &x; }
+
+    size_type max_size() const { return size_t(-1) / sizeof(T); }
+};
+
+// all the allocators with the same Alloc share one pool
+template <class T1, class T2, class Alloc>
+inline bool operator==(const allocator<T1, Alloc>&, const allocator<T2, Alloc>&)
+{
+    return true;
+}
+
+template <class T1, class T2, class Alloc>
+inline bool operator!=(const allocator<T1, Alloc>&, const allocator<T2, Alloc>&)
+{
+    return false;
+}
+
+} // namespace mtl
+
+#endif
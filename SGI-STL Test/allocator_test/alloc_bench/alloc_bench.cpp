@@ -0,0 +1,351 @@
+// stl_config.h 只认识 gcc 2.x, 现代 g++ 的这些特性要手动打开
+#define __STL_CLASS_PARTIAL_SPECIALIZATION
+#define __STL_FUNCTION_TMPL_PARTIAL_ORDER
+#define __STL_EXPLICIT_FUNCTION_TMPL_ARGS
+#define __STL_MEMBER_TEMPLATES
+#define __STL_MEMBER_TEMPLATE_CLASSES
+#define __STL_TEMPLATE_FRIENDS
+#include <stl_config.h>
+#include <stl_alloc.h>
+#include <pthread_alloc>
+#include "../myAllocator/myAllocator.h"
+#include <ext/hash_map>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <map>
+#include <thread>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+// 配置器基准测试: 吞吐量, p99 延迟, 峰值 RSS
+// 负载: 单线程 churn, 生产者/消费者(跨线程释放), 混合大小,
+//       以及 map 插入删除, list splice, hash_map rehash
+// 比较 SGI alloc, malloc_alloc, pthread_alloc, myAllocator 和系统 malloc
+// 编译: g++ -std=c++11 -O2 -pthread -Wno-deprecated -idirafter "../../../SGI-STL V3.3" alloc_bench.cpp
+// 用法: ./a.out [负载名] [配置器名]   只跑名字匹配的组合
+//
+// 每个组合在 fork 出来的子进程里跑 REPEAT 次, 取吞吐量的中位数;
+// 这样峰值 RSS 互不影响, 内存池也不会被上一个组合预热.
+// 随机数种子固定, 每次运行的操作序列完全相同.
+// 延迟每 SAMPLE 次操作采样一次, 计时本身的开销也算进了吞吐量.
+
+const int N = 2000000;        // 每个负载的操作数
+const int LIVE = 16384;       // churn 时同时存活的块数
+const int REPEAT = 3;
+const int SAMPLE = 16;
+
+typedef chrono::steady_clock Clock;
+
+// 固定种子的 xorshift, 不受 libc rand() 实现影响
+struct Random {
+	unsigned s;
+	explicit Random(unsigned seed) : s(seed) {}
+	unsigned operator()() { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+};
+
+// 采样的单次操作延迟(ns)
+struct Latency {
+	vector<unsigned> ns;
+	unsigned n;
+	Latency() : n(0) { ns.reserve(N / SAMPLE * 2 + 16); }
+
+	template <class Op>
+	void run(Op op) {
+		if (n++ % SAMPLE) { op(); return; }
+		Clock::time_point t = Clock::now();
+		op();
+		ns.push_back((unsigned)chrono::duration_cast<chrono::nanoseconds>(Clock::now() - t).count());
+	}
+
+	void merge(const Latency& o) { n += o.n; ns.insert(ns.end(), o.ns.begin(), o.ns.end()); }
+
+	double p99() {
+		if (ns.empty()) return 0;
+		size_t k = ns.size() * 99 / 100;
+		nth_element(ns.begin(), ns.begin() + k, ns.end());
+		return ns[k];
+	}
+};
+
+// 统一成 allocate(n) / deallocate(p, n) 的静态接口
+struct Malloc {
+	static void* allocate(size_t n) { return malloc(n); }
+	static void deallocate(void* p, size_t) { free(p); }
+};
+
+struct MyAlloc {
+	static void* allocate(size_t n) { return myAllocator::allocator<char>().allocate(n); }
+	static void deallocate(void* p, size_t n) { myAllocator::allocator<char>().deallocate((char*)p, n); }
+};
+
+// 把上面的静态接口包装成容器用的标准配置器
+template <class T, class Raw>
+struct bench_allocator {
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	template <class U> struct rebind { typedef bench_allocator<U, Raw> other; };
+
+	bench_allocator() {}
+	template <class U> bench_allocator(const bench_allocator<U, Raw>&) {}
+
+	T* allocate(size_t n, const void* = 0) { return (T*)Raw::allocate(n * sizeof(T)); }
+	void deallocate(T* p, size_t n) { Raw::deallocate(p, n * sizeof(T)); }
+	size_t max_size() const { return size_t(-1) / sizeof(T); }
+	void construct(T* p, const T& v) { new(p) T(v); }
+	void destroy(T* p) { p->~T(); }
+	bool operator==(const bench_allocator&) const { return true; }
+	bool operator!=(const bench_allocator&) const { return false; }
+};
+
+// 单线程 churn: 随机替换存活表里的一块, 大小 8~128 字节(节点大小)
+template <class Raw>
+void churn(Latency& lat)
+{
+	vector<pair<void*, size_t> > live(LIVE, make_pair((void*)0, (size_t)0));
+	Random r(1);
+	for (int i = 0; i < N; i++) {
+		pair<void*, size_t>& e = live[r() % LIVE];
+		size_t n = 8 + r() % 121;
+		lat.run([&] {
+			if (e.first) Raw::deallocate(e.first, e.second);
+			e.first = Raw::allocate(n);
+			e.second = n;
+		});
+		*(char*)e.first = 0;
+	}
+	for (int i = 0; i < LIVE; i++)
+		if (live[i].first) Raw::deallocate(live[i].first, live[i].second);
+}
+
+// 混合大小: 按对数分布取 8 字节 ~ 16KB, 大块会越过节点配置器的上限
+template <class Raw>
+void mixed(Latency& lat)
+{
+	vector<pair<void*, size_t> > live(LIVE, make_pair((void*)0, (size_t)0));
+	Random r(2);
+	for (int i = 0; i < N; i++) {
+		pair<void*, size_t>& e = live[r() % LIVE];
+		size_t n = (size_t)8 << (r() % 12);
+		n += r() % n;
+		lat.run([&] {
+			if (e.first) Raw::deallocate(e.first, e.second);
+			e.first = Raw::allocate(n);
+			e.second = n;
+		});
+		*(char*)e.first = 0;
+	}
+	for (int i = 0; i < LIVE; i++)
+		if (live[i].first) Raw::deallocate(live[i].first, live[i].second);
+}
+
+// 生产者/消费者: 生产者分配, 经无锁环形队列交给消费者释放
+// 每对线程一个队列, 所有块都在另一个线程上释放
+const int PAIRS = 2;
+const int RING = 4096;
+
+struct Ring {
+	pair<void*, size_t> slot[RING];
+	atomic<unsigned> head, tail;
+	Ring() : head(0), tail(0) {}
+};
+
+template <class Raw>
+void producer_consumer(Latency& lat)
+{
+	vector<Ring> rings(PAIRS);
+	vector<Latency> lats(PAIRS * 2);
+	vector<thread> ts;
+	for (int k = 0; k < PAIRS; k++) {
+		Ring* q = &rings[k];
+		Latency* pl = &lats[2 * k];
+		Latency* cl = &lats[2 * k + 1];
+		ts.push_back(thread([=] {
+			Random r(3 + k);
+			for (int i = 0; i < N / PAIRS; i++) {
+				size_t n = 8 + r() % 121;
+				void* p;
+				pl->run([&] { p = Raw::allocate(n); });
+				*(char*)p = 0;
+				unsigned h = q->head.load(memory_order_relaxed);
+				while (h - q->tail.load(memory_order_acquire) == RING)
+					this_thread::yield();
+				q->slot[h % RING] = make_pair(p, n);
+				q->head.store(h + 1, memory_order_release);
+			}
+		}));
+		ts.push_back(thread([=] {
+			for (int i = 0; i < N / PAIRS; i++) {
+				unsigned t = q->tail.load(memory_order_relaxed);
+				while (q->head.load(memory_order_acquire) == t)
+					this_thread::yield();
+				pair<void*, size_t> e = q->slot[t % RING];
+				q->tail.store(t + 1, memory_order_release);
+				cl->run([&] { Raw::deallocate(e.first, e.second); });
+			}
+		}));
+	}
+	for (size_t i = 0; i < ts.size(); i++)
+		ts[i].join();
+	for (size_t i = 0; i < lats.size(); i++)
+		lat.merge(lats[i]);
+}
+
+// map: 稳定在 LIVE 个元素, 随机插入一个再删除一个
+template <class Raw>
+void map_churn(Latency& lat)
+{
+	typedef bench_allocator<pair<const int, int>, Raw> A;
+	map<int, int, less<int>, A> m;
+	Random r(4);
+	for (int i = 0; i < N / 2; i++) {
+		int k = (int)(r() % (LIVE * 4));
+		lat.run([&] { m[k] = i; });
+		if (m.size() > (size_t)LIVE) {
+			int e = (int)(r() % (LIVE * 4));
+			lat.run([&] {
+				typename map<int, int, less<int>, A>::iterator it = m.lower_bound(e);
+				m.erase(it == m.end() ? m.begin() : it);
+			});
+		}
+	}
+}
+
+// list: 尾部插入一批, 整批 splice 到另一个 list, 再从那边头部删除
+// 节点在一个 list 里分配, 在另一个 list 里释放
+template <class Raw>
+void list_splice(Latency& lat)
+{
+	typedef list<int, bench_allocator<int, Raw> > List;
+	List a, b;
+	const int BATCH = 256;
+	for (int i = 0; i < N / BATCH / 2; i++) {
+		for (int j = 0; j < BATCH; j++)
+			lat.run([&] { a.push_back(j); });
+		b.splice(b.end(), a);
+		while (b.size() > (size_t)LIVE)
+			lat.run([&] { b.pop_front(); });
+	}
+}
+
+// hash_map: 从空表插入到 LIVE*8 个元素, 过程中反复 rehash; 然后清空重来
+template <class Raw>
+void hash_map_rehash(Latency& lat)
+{
+	typedef __gnu_cxx::hash_map<int, int, __gnu_cxx::hash<int>, equal_to<int>,
+	                            bench_allocator<int, Raw> > HashMap;
+	Random r(5);
+	for (int done = 0; done < N; ) {
+		HashMap h;
+		for (int i = 0; i < LIVE * 8; i++, done++) {
+			int k = (int)r();
+			lat.run([&] { h[k] = i; });
+		}
+	}
+}
+
+typedef void (*Work)(Latency&);
+
+struct Result {
+	double mops;
+	double p99;
+	long rss_kb;
+};
+
+Result measure(Work work)
+{
+	Latency lat;
+	Clock::time_point start = Clock::now();
+	work(lat);
+	chrono::duration<double> s = Clock::now() - start;
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	Result res = { lat.n / s.count() / 1e6, lat.p99(), ru.ru_maxrss };
+	return res;
+}
+
+// 在子进程里跑, 结果通过管道传回
+bool run_child(Work work, Result& res)
+{
+	int fd[2];
+	if (pipe(fd) != 0) return false;
+	pid_t pid = fork();
+	if (pid == 0) {
+		close(fd[0]);
+		Result r = measure(work);
+		ssize_t w = write(fd[1], &r, sizeof(r));
+		_exit(w == (ssize_t)sizeof(r) ? 0 : 1);
+	}
+	close(fd[1]);
+	bool ok = pid > 0 && read(fd[0], &res, sizeof(res)) == (ssize_t)sizeof(res);
+	close(fd[0]);
+	int status;
+	if (pid > 0) waitpid(pid, &status, 0);
+	return ok;
+}
+
+const char* want_work = 0;
+const char* want_alloc = 0;
+
+void run(const char* work_name, Work work, const char* alloc_name)
+{
+	if ((want_work && strcmp(want_work, work_name)) || (want_alloc && strcmp(want_alloc, alloc_name)))
+		return;
+	vector<Result> rs;
+	for (int i = 0; i < REPEAT; i++) {
+		Result r;
+		if (run_child(work, r)) rs.push_back(r);
+	}
+	if (rs.empty()) {
+		printf("%-18s%-16s%12s\n", work_name, alloc_name, "failed");
+		return;
+	}
+	sort(rs.begin(), rs.end(), [](const Result& x, const Result& y) { return x.mops < y.mops; });
+	Result& m = rs[rs.size() / 2];
+	printf("%-18s%-16s%12.2f%12.0f%12.1f\n", work_name, alloc_name, m.mops, m.p99, m.rss_kb / 1024.0);
+	fflush(stdout);
+}
+
+template <class Raw>
+Work pick(const char* work_name)
+{
+	if (!strcmp(work_name, "churn")) return churn<Raw>;
+	if (!strcmp(work_name, "producer_consumer")) return producer_consumer<Raw>;
+	if (!strcmp(work_name, "mixed")) return mixed<Raw>;
+	if (!strcmp(work_name, "map")) return map_churn<Raw>;
+	if (!strcmp(work_name, "list_splice")) return list_splice<Raw>;
+	return hash_map_rehash<Raw>;
+}
+
+// 同一个负载的各个配置器放在一起, 方便对比
+void run_all(const char* work_name)
+{
+	run(work_name, pick<Malloc>(work_name), "malloc");
+	run(work_name, pick<malloc_alloc>(work_name), "malloc_alloc");
+	run(work_name, pick<alloc>(work_name), "alloc");
+	run(work_name, pick<pthread_alloc>(work_name), "pthread_alloc");
+	run(work_name, pick<MyAlloc>(work_name), "myAllocator");
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1) want_work = argv[1];
+	if (argc > 2) want_alloc = argv[2];
+	printf("%-18s%-16s%12s%12s%12s\n", "workload", "allocator", "Mops/s", "p99(ns)", "peakRSS(MB)");
+	const char* works[] = { "churn", "producer_consumer", "mixed", "map", "list_splice", "hash_map_rehash" };
+	for (size_t i = 0; i < sizeof(works) / sizeof(works[0]); i++)
+		run_all(works[i]);
+}
@@ -0,0 +1,356 @@
+// stl_config.h 只认识 gcc 2.x, 现代 g++ 的这些特性要手动打开
+#define __STL_CLASS_PARTIAL_SPECIALIZATION
+#define __STL_FUNCTION_TMPL_PARTIAL_ORDER
+#define __STL_EXPLICIT_FUNCTION_TMPL_ARGS
+#define __STL_MEMBER_TEMPLATES
+#define __STL_MEMBER_TEMPLATE_CLASSES
+#define __STL_TEMPLATE_FRIENDS
+#define __STL_ALLOC_TRACING
+#include <stl_config.h>
+#include <stl_alloc.h>
+#include <vector>
+#include <map>
+#include <queue>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+// 轨迹回放: 用 alloc_tracer 录下的请求序列, 模拟 __default_alloc_template
+// 在不同 size class 表和 chunk 大小下的表现, 不真的分配内存.
+// 报告峰值时的堆大小, 其中 _S_round_up 浪费的和空闲在 free list/内存池里的
+// 比例, 向 malloc 要 chunk 的次数, 越过 _MAX_BYTES 直接走 malloc 的请求数,
+// 以及加锁次数(全局锁模式, 和 __STL_NODE_ALLOCATOR_THREAD_CACHE 的弹匣模式).
+//
+// 录制: 被测程序加 -D__STL_ALLOC_TRACING 编译, 然后
+//     alloc_tracer::start("/tmp/app.trace");  ...  alloc_tracer::stop();
+// 各线程的记录在文件里是一段一段交错的, 按记录里的全局序号归并回原来的顺序.
+// 录制之前分配的块, 它的释放没有对应的分配, 回放时跳过, 只报个数;
+// 所以最好一开始就 start.
+// 编译: g++ -std=c++11 -O2 -pthread -Wno-deprecated -idirafter "../../../SGI-STL V3.3" alloc_replay.cpp
+// 用法: ./a.out 轨迹文件 [size class 表名] [chunk 名]   只跑名字匹配的组合
+//
+// 模型只数个数: free list 的长度, 内存池剩下的字节, 从 malloc 拿的字节.
+// 堆只增不减 (release_unused 不模拟), 所以峰值就是结束时的堆.
+// allocate_n_nodes 在轨迹里是一个个的分配, 它省下的锁这里不算.
+// 线程退出时弹匣归还的那一次加锁也不算.
+
+const int REFILL = 20;          // 和 _S_refill_n 一次取的个数一样
+const int MAGAZINE_BATCH = 16;  // 和 _S_MAGAZINE_BATCH 一样
+
+// 和 __STL_NODE_ALLOCATOR_TRIM 的 _Chunk 一样大
+struct ChunkHeader {
+	void* next;
+	size_t live;
+	bool from_malloc;
+	int inst;
+};
+
+typedef alloc_tracer::_Record Record;
+
+struct Trace {
+	vector<Record> records;
+	unsigned threads;
+	size_t allocs;
+	size_t frees;
+	size_t unmatched;   // 录制之前分配的块的释放, 已去掉
+};
+
+// 序号会回绕, 按序列号算术比较: a 在 b 之前
+bool before(unsigned a, unsigned b)
+{
+	return (int)(a - b) < 0;
+}
+
+// 各线程的下一条记录, 序号最小的在堆顶
+struct Head {
+	unsigned seq;
+	unsigned thread;
+	bool operator<(const Head& h) const { return before(h.seq, seq); }
+};
+
+bool load(const char* path, Trace& t)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		return false;
+	}
+	char magic[8];
+	unsigned header[2];
+	if (fread(magic, 1, 8, f) != 8 || memcmp(magic, "STLTRACE", 8) ||
+	    fread(header, sizeof(header), 1, f) != 1 ||
+	    header[0] != (unsigned)alloc_tracer::_S_VERSION || header[1] != sizeof(Record)) {
+		fprintf(stderr, "%s: 不是这个版本的 alloc_tracer 轨迹\n", path);
+		fclose(f);
+		return false;
+	}
+	// 先按线程分开, 每个线程内部保持文件里的顺序
+	vector<vector<Record> > per_thread;
+	Record buf[4096];
+	size_t k;
+	while ((k = fread(buf, sizeof(Record), 4096, f)) > 0)
+		for (size_t i = 0; i < k; i++) {
+			unsigned thread = buf[i]._M_thread_op >> 1;
+			if (thread >= per_thread.size()) per_thread.resize(thread + 1);
+			per_thread[thread].push_back(buf[i]);
+		}
+	fclose(f);
+	t.threads = (unsigned)per_thread.size();
+
+	// 多路归并; 顺便去掉没有对应分配的释放 (按请求的大小配对)
+	vector<size_t> next(per_thread.size(), 0);
+	priority_queue<Head> heads;
+	for (unsigned i = 0; i < per_thread.size(); i++)
+		if (!per_thread[i].empty()) {
+			Head h = { per_thread[i][0]._M_seq, i };
+			heads.push(h);
+		}
+	map<unsigned, size_t> live;
+	t.allocs = t.frees = t.unmatched = 0;
+	while (!heads.empty()) {
+		Head h = heads.top();
+		heads.pop();
+		const Record& r = per_thread[h.thread][next[h.thread]++];
+		if (next[h.thread] < per_thread[h.thread].size()) {
+			Head n = { per_thread[h.thread][next[h.thread]]._M_seq, h.thread };
+			heads.push(n);
+		}
+		if ((r._M_thread_op & 1) == alloc_tracer::_S_DEALLOCATE) {
+			size_t& m = live[r._M_size];
+			if (m == 0) {
+				t.unmatched++;
+				continue;
+			}
+			m--;
+			t.frees++;
+		} else {
+			live[r._M_size]++;
+			t.allocs++;
+		}
+		t.records.push_back(r);
+	}
+	return true;
+}
+
+// chunk 的取法
+struct Chunking {
+	const char* name;
+	size_t fixed;   // 0: 原来的 2 * 需求量 + 附加量, 否则是 TRIM 模式的固定大小
+	bool huge;      // 按 _Huge_page_chunk_source 取整到 2M
+};
+
+struct Result {
+	size_t heap;           // 从 malloc 拿的 chunk 字节
+	size_t peak_rounded;   // 峰值时客户手里的字节 (按 size class)
+	size_t peak_requested; // 同一时刻客户要的字节
+	size_t chunks;
+	size_t refills;
+	size_t large;          // 越过 _MAX_BYTES 的请求
+	size_t locks;
+};
+
+template <class Classes>
+struct Pool {
+	const Chunking& chunking;
+	size_t header;
+	vector<size_t> free_count;  // 每个 size class 的 free list 长度
+	size_t pool_left;           // 内存池里还没切出去的字节
+	Result r;
+
+	explicit Pool(const Chunking& c) : chunking(c), free_count(Classes::_NFREELISTS, 0), pool_left(0)
+	{
+		header = c.fixed ? (sizeof(ChunkHeader) + Classes::_ALIGN - 1) & ~(size_t)(Classes::_ALIGN - 1) : 0;
+		memset(&r, 0, sizeof(r));
+	}
+
+	static size_t align_up(size_t n) { return (n + Classes::_ALIGN - 1) & ~(size_t)(Classes::_ALIGN - 1); }
+
+	// _S_chunk_alloc: 从内存池切 nobjs 个 size 大小的块, 不够就向 malloc 要
+	void chunk_alloc(size_t size, int& nobjs)
+	{
+		for (;;) {
+			size_t total = size * nobjs;
+			if (pool_left >= total) {
+				pool_left -= total;
+				return;
+			}
+			if (pool_left >= size) {
+				nobjs = (int)(pool_left / size);
+				pool_left -= nobjs * size;
+				return;
+			}
+			size_t get;
+			if (chunking.fixed)
+				get = chunking.fixed;
+			else if (chunking.huge)
+				get = _Huge_page_chunk_source::_S_good_size(2 * total + align_up(r.heap >> 4));
+			else
+				get = _Malloc_chunk_source::_S_good_size(2 * total + align_up(r.heap >> 4));
+			// 剩下的零头给能装下它的最大的 size class
+			if (pool_left > 0) {
+				size_t i = Classes::_S_freelist_index(pool_left);
+				if (Classes::_S_class_size(i) > pool_left) --i;
+				free_count[i]++;
+			}
+			r.heap += get;
+			r.chunks++;
+			pool_left = get - header;
+		}
+	}
+
+	// free list 空了: 切 REFILL 个新块放上去
+	void refill(size_t i)
+	{
+		int nobjs = REFILL;
+		chunk_alloc(Classes::_S_class_size(i), nobjs);
+		free_count[i] += nobjs;
+		r.refills++;
+	}
+};
+
+// 全局锁模式: 每次小块的分配和释放都加一次锁
+template <class Classes>
+Result replay_locked(const Trace& t, const Chunking& c)
+{
+	Pool<Classes> p(c);
+	size_t rounded = 0, requested = 0;
+	for (size_t k = 0; k < t.records.size(); k++) {
+		size_t n = t.records[k]._M_size;
+		bool is_free = (t.records[k]._M_thread_op & 1) == alloc_tracer::_S_DEALLOCATE;
+		if (n > (size_t)Classes::_MAX_BYTES) {
+			if (!is_free) p.r.large++;
+			continue;
+		}
+		size_t i = Classes::_S_freelist_index(n);
+		p.r.locks++;
+		if (is_free) {
+			p.free_count[i]++;
+			rounded -= Classes::_S_class_size(i);
+			requested -= n;
+			continue;
+		}
+		if (p.free_count[i] == 0) p.refill(i);
+		p.free_count[i]--;
+		rounded += Classes::_S_class_size(i);
+		requested += n;
+		if (rounded > p.r.peak_rounded) {
+			p.r.peak_rounded = rounded;
+			p.r.peak_requested = requested;
+		}
+	}
+	return p.r;
+}
+
+// 弹匣模式: 每个线程每个 size class 一个弹匣, 空了才加锁取一批,
+// 攒到两批才加锁还一批
+template <class Classes>
+Result replay_magazine(const Trace& t, const Chunking& c)
+{
+	Pool<Classes> p(c);
+	vector<vector<int> > magazine(t.threads, vector<int>(Classes::_NFREELISTS, 0));
+	size_t rounded = 0, requested = 0;
+	for (size_t k = 0; k < t.records.size(); k++) {
+		size_t n = t.records[k]._M_size;
+		unsigned thread = t.records[k]._M_thread_op >> 1;
+		bool is_free = (t.records[k]._M_thread_op & 1) == alloc_tracer::_S_DEALLOCATE;
+		if (n > (size_t)Classes::_MAX_BYTES) {
+			if (!is_free) p.r.large++;
+			continue;
+		}
+		size_t i = Classes::_S_freelist_index(n);
+		int& m = magazine[thread][i];
+		if (is_free) {
+			if (++m >= 2 * MAGAZINE_BATCH) {
+				p.r.locks++;
+				m -= MAGAZINE_BATCH;
+				p.free_count[i] += MAGAZINE_BATCH;
+			}
+			rounded -= Classes::_S_class_size(i);
+			requested -= n;
+			continue;
+		}
+		if (m == 0) {
+			p.r.locks++;
+			if (p.free_count[i] == 0) p.refill(i);
+			size_t take = p.free_count[i] < (size_t)MAGAZINE_BATCH ? p.free_count[i] : MAGAZINE_BATCH;
+			p.free_count[i] -= take;
+			m = (int)take;
+		}
+		m--;
+		rounded += Classes::_S_class_size(i);
+		requested += n;
+		if (rounded > p.r.peak_rounded) {
+			p.r.peak_rounded = rounded;
+			p.r.peak_requested = requested;
+		}
+	}
+	return p.r;
+}
+
+const char* want_classes = 0;
+const char* want_chunk = 0;
+
+void print(const char* classes, size_t lists, const char* chunk, const char* mode, const Result& r)
+{
+	double heap = r.heap ? (double)r.heap : 1;
+	printf("%-24s%6lu  %-9s%-10s%11.0f%11.0f%10.1f%10.1f%9lu%9lu%12lu\n",
+	       classes, (unsigned long)lists, chunk, mode, r.heap / 1024.0, r.peak_requested / 1024.0,
+	       100.0 * (r.peak_rounded - r.peak_requested) / heap,
+	       100.0 * (r.heap - r.peak_rounded) / heap,
+	       (unsigned long)r.chunks, (unsigned long)r.large, (unsigned long)r.locks);
+	fflush(stdout);
+}
+
+template <class Classes>
+void run(const Trace& t, const char* name, const Chunking* chunkings, size_t nchunkings)
+{
+	if (want_classes && strcmp(want_classes, name)) return;
+	for (size_t k = 0; k < nchunkings; k++) {
+		const Chunking& c = chunkings[k];
+		if (want_chunk && strcmp(want_chunk, c.name)) continue;
+		// 固定大小的 chunk 至少要装得下一个最大的块
+		if (c.fixed && c.fixed < (size_t)Classes::_MAX_BYTES + sizeof(ChunkHeader) + Classes::_ALIGN) {
+			printf("%-24s%6lu  %-9s%-10s%11s\n", name, (unsigned long)Classes::_NFREELISTS, c.name, "", "n/a");
+			continue;
+		}
+		print(name, Classes::_NFREELISTS, c.name, "lock", replay_locked<Classes>(t, c));
+		print(name, Classes::_NFREELISTS, c.name, "magazine", replay_magazine<Classes>(t, c));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "用法: %s 轨迹文件 [size class 表名] [chunk 名]\n", argv[0]);
+		return 2;
+	}
+	if (argc > 2) want_classes = argv[2];
+	if (argc > 3) want_chunk = argv[3];
+	Trace t;
+	if (!load(argv[1], t)) return 1;
+	printf("%lu 次分配, %lu 次释放, %u 个线程", (unsigned long)t.allocs, (unsigned long)t.frees, t.threads);
+	if (t.unmatched)
+		printf(", 跳过 %lu 次录制之前分配的块的释放", (unsigned long)t.unmatched);
+	printf("\n\n");
+	// heap = 峰值时客户要的 + round-up 浪费的 + free list 和内存池里空着的
+	printf("%-24s%6s  %-9s%-10s%11s%11s%10s%10s%9s%9s%12s\n", "size classes", "lists", "chunk", "mode",
+	       "heap(KB)", "live(KB)", "roundup%", "slack%", "chunks", "malloc", "locks");
+
+	const Chunking chunkings[] = {
+		{ "grow", 0, false },     // 原来的做法
+		{ "grow-2M", 0, true },   // __STL_USE_HUGE_PAGES
+		{ "16K", 16 * 1024, false },
+		{ "64K", 64 * 1024, false },
+		{ "256K", 256 * 1024, false },
+	};
+	const size_t n = sizeof(chunkings) / sizeof(chunkings[0]);
+	run<_Linear_size_classes<8, 128> >(t, "linear<8,128>", chunkings, n);
+	run<_Linear_size_classes<16, 128> >(t, "linear<16,128>", chunkings, n);
+	run<_Linear_size_classes<8, 256> >(t, "linear<8,256>", chunkings, n);
+	run<_Geometric_size_classes<8, 128, 1024, 4> >(t, "geometric<8,128,1024,4>", chunkings, n);
+	run<_Geometric_size_classes<8, 128, 4096, 4> >(t, "geometric<8,128,4096,4>", chunkings, n);
+	run<_Geometric_size_classes<16, 256, 4096, 4> >(t, "geometric<16,256,4096,4>", chunkings, n);
+	run<_Geometric_size_classes<8, 64, 4096, 8> >(t, "geometric<8,64,4096,8>", chunkings, n);
+}
@@ -0,0 +1,118 @@
+// stl_config.h 只认识 gcc 2.x, 现代 g++ 的这些特性要手动打开
+#define __STL_CLASS_PARTIAL_SPECIALIZATION
+#define __STL_FUNCTION_TMPL_PARTIAL_ORDER
+#define __STL_EXPLICIT_FUNCTION_TMPL_ARGS
+#define __STL_MEMBER_TEMPLATES
+#define __STL_MEMBER_TEMPLATE_CLASSES
+#define __STL_TEMPLATE_FRIENDS
+#include <stl_config.h>
+#include <stl_alloc.h>
+#include <stl_algobase.h>
+#include <stl_construct.h>
+#include <stl_uninitialized.h>
+#include <stl_function.h>
+#include <stl_vector.h>
+#include <stl_deque.h>
+#include <arena_alloc>
+#include <stdio.h>
+
+using namespace std;
+
+// 作用域配置器: 建在 arena 上的 vector / deque, 复制进来的内层容器
+// 也要从同一个 arena 分配 (见 stl_construct.h 的 _Construct_scoped).
+// 内层容器先建在另一个 arena (other) 上, 再用各种方式复制进外层容器:
+// 构造, push_back / push_front, 区间和填充 insert, assign, 扩容搬迁,
+// 带配置器的复制构造.
+// 检查每个内层容器的配置器指向外层的 arena, 外层 arena 装得下内层的元素,
+// 最后释放 other, 内层容器的内容还在.
+// 编译: g++ -O2 -idirafter "../../../SGI-STL V3.3" arena_nested.cpp
+// (用 SGI STL 3.3 支持的编译器; g++ 3.4 起要先给 stl_vector.h, stl_deque.h
+//  里用到基类成员的地方加上 this->)
+
+typedef arena_allocator<int> IA;
+typedef vector<int, IA> IV;
+typedef deque<int, IA> ID;
+
+const int N = 100;
+int errors;
+
+template <class Inner>
+void fill_inner(Inner& c)
+{
+	for (int i = 0; i < N; i++)
+		c.push_back(i);
+}
+
+// 每个元素都在 arena 上, 且内容完整
+template <class Outer>
+void check(const char* name, const Outer& outer, monotonic_arena& arena)
+{
+	int n = 0;
+	for (typename Outer::const_iterator it = outer.begin(); it != outer.end(); ++it, ++n) {
+		if (it->get_allocator().arena() != &arena) {
+			printf("%s: 第 %d 个元素不在外层的 arena 上\n", name, n);
+			errors++;
+			return;
+		}
+		if (it->size() != (size_t)N || (*it)[N - 1] != N - 1) {
+			printf("%s: 第 %d 个元素内容不对\n", name, n);
+			errors++;
+			return;
+		}
+	}
+}
+
+// 在 other 上建内层容器, 复制进外层容器, 然后释放 other
+template <class Outer>
+void test(const char* name)
+{
+	typedef typename Outer::value_type Inner;
+	typedef typename Outer::allocator_type OA;
+	monotonic_arena arena;
+	monotonic_arena other;
+	Inner src((IA(other)));
+	fill_inner(src);
+	Inner srcs[3] = { src, src, src };
+
+	Outer outer((OA(arena)));
+	for (int i = 0; i < 10; i++)          // 扩容时搬迁已有的元素
+		outer.push_back(src);
+	outer.insert(outer.begin() + 5, src);
+	outer.insert(outer.begin() + 2, srcs, srcs + 3);
+	outer.insert(outer.end(), 4, src);
+	if (arena.bytes_allocated() < outer.size() * N * sizeof(int)) {
+		printf("%s: arena 只分配了 %d 字节, 内层的元素不在上面\n", name,
+		       (int)arena.bytes_allocated());
+		errors++;
+	}
+	Outer assigned((OA(arena)));
+	assigned.assign(srcs, srcs + 3);
+	Outer filled(3, src, OA(arena));
+	Outer ranged(srcs, srcs + 3, OA(arena));
+
+	monotonic_arena arena2;
+	Outer copied(outer, OA(arena2));      // 带配置器的复制构造换到 arena2
+	Outer same(outer);                    // 普通复制构造留在原 arena
+
+	other.release();   // 不该再有内层容器用它的内存
+
+	check(name, outer, arena);
+	check(name, assigned, arena);
+	check(name, filled, arena);
+	check(name, ranged, arena);
+	check(name, copied, arena2);
+	check(name, same, arena);
+	printf("%s: %d 个元素, arena 分配了 %d 字节\n", name, (int)outer.size(),
+	       (int)arena.bytes_allocated());
+}
+
+int main()
+{
+	test<vector<IV, arena_allocator<IV> > >("vector<vector>");
+	test<vector<ID, arena_allocator<ID> > >("vector<deque>");
+	test<deque<IV, arena_allocator<IV> > >("deque<vector>");
+	test<deque<ID, arena_allocator<ID> > >("deque<deque>");
+
+	printf(errors ? "失败\n" : "通过\n");
+	return errors != 0;
+}
@@ -0,0 +1,97 @@
+#include "../../../MTL V0.1/mtl_alloc.h"
+#include "../myAllocator/myAllocator.h"
+#include <ext/pool_allocator.h>  // __pool_alloc: libstdc++ 里的 SGI alloc (__default_alloc_template)
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+// 节点密集型的负载: list / map / set 的频繁插入删除
+// 比较 mtl::alloc, mtl::thread_alloc, myAllocator::allocator, SGI alloc 和 std::allocator
+// 编译: g++ -std=c++11 -O2 -pthread mtl_alloc_bench.cpp
+
+const int N = 200000;
+const int ROUNDS = 10;
+const int THREADS = 4;
+
+// list: 一直在尾部插入, 头部删除
+template <class Alloc>
+void list_churn()
+{
+	list<int, Alloc> l;
+	for (int r = 0; r < ROUNDS; r++) {
+		for (int i = 0; i < N; i++)
+			l.push_back(i);
+		while (!l.empty())
+			l.pop_front();
+	}
+}
+
+// map: 随机 key 插入, 再全部删除
+template <class Alloc>
+void map_churn()
+{
+	typedef map<int, int, less<int>, typename Alloc::template rebind<pair<const int, int> >::other> Map;
+	Map m;
+	srand(1);
+	for (int r = 0; r < ROUNDS; r++) {
+		for (int i = 0; i < N; i++)
+			m[rand()] = i;
+		m.clear();
+	}
+}
+
+// set: 插入和删除交替, 节点一直被复用
+template <class Alloc>
+void set_churn()
+{
+	set<int, less<int>, Alloc> s;
+	for (int r = 0; r < ROUNDS; r++) {
+		for (int i = 0; i < N; i++) {
+			s.insert(i);
+			if (i % 2) s.erase(i - 1);
+		}
+		s.clear();
+	}
+}
+
+// 多线程同时做 list_churn
+template <class Alloc>
+void threaded_churn()
+{
+	vector<thread> ts;
+	for (int i = 0; i < THREADS; i++)
+		ts.push_back(thread(list_churn<Alloc>));
+	for (size_t i = 0; i < ts.size(); i++)
+		ts[i].join();
+}
+
+template <class Alloc>
+void run(const char* name)
+{
+	void (*tests[])() = { list_churn<Alloc>, map_churn<Alloc>, set_churn<Alloc>, threaded_churn<Alloc> };
+	printf("%-24s", name);
+	for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		tests[i]();
+		chrono::duration<double, milli> ms = chrono::steady_clock::now() - start;
+		printf("%12.1f", ms.count());
+	}
+	printf("\n");
+}
+
+int main()
+{
+	printf("%-24s%12s%12s%12s%12s   (ms)\n", "allocator", "list", "map", "set", "threads");
+	run<allocator<int> >("std::allocator");
+	run<myAllocator::allocator<int> >("myAllocator::allocator");
+	run<__gnu_cxx::__pool_alloc<int> >("SGI alloc");
+	run<mtl::allocator<int, mtl::alloc> >("mtl::alloc");
+	run<mtl::allocator<int, mtl::thread_alloc> >("mtl::thread_alloc");
+}
@@ -0,0 +1,154 @@
+// stl_config.h 只认识 gcc 2.x, 现代 g++ 的这些特性要手动打开
+#define __STL_CLASS_PARTIAL_SPECIALIZATION
+#define __STL_FUNCTION_TMPL_PARTIAL_ORDER
+#define __STL_EXPLICIT_FUNCTION_TMPL_ARGS
+#define __STL_MEMBER_TEMPLATES
+#define __STL_MEMBER_TEMPLATE_CLASSES
+#define __STL_TEMPLATE_FRIENDS
+#include <stl_config.h>
+#include <stl_alloc.h>
+#include <stl_algobase.h>
+#include <stl_construct.h>
+#include <stl_uninitialized.h>
+#include <stl_function.h>
+#include <stl_tree.h>
+#include <stl_set.h>
+#include <stl_multiset.h>
+#include <stl_vector.h>
+#include <stl_hash_fun.h>
+#include <stl_hashtable.h>
+#include <stl_hash_set.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace std;
+
+// 区间 insert 一次向配置器要一批节点, 配置器中途抛异常时
+// 不能泄漏已经拿到的节点, 也不能归还还没拿到的节点.
+// 让配置器在第 k 次分配时抛 bad_alloc, k 从 1 数到插入不再抛为止,
+// 每次之后检查容器还能用, 容器析构后所有块都已归还, 且没有归还过陌生的块.
+// 覆盖 set/multiset (红黑树) 和 hash_set/hash_multiset (hashtable) 的
+// insert_unique / insert_equal 区间版本.
+// 编译: g++ -O2 -idirafter "../../../SGI-STL V3.3" batch_insert.cpp
+// (用 SGI STL 3.3 支持的编译器; g++ 3.4 起要先给 stl_tree.h, stl_vector.h
+//  里用到基类成员的地方加上 this->)
+
+const int N = 200;
+const int DISTINCT = 150;   // 有重复的 key, 重复的不占节点
+
+int allocs;                 // 本轮分配次数
+int fail_at;                // 第几次分配抛异常, 0 表示不抛
+void* live[4 * N];          // 没有归还的块
+int nlive;
+bool bad_free;              // 归还了不是分配出去的块
+
+template <class T>
+class throwing_allocator {
+public:
+	typedef size_t    size_type;
+	typedef ptrdiff_t difference_type;
+	typedef T*        pointer;
+	typedef const T*  const_pointer;
+	typedef T&        reference;
+	typedef const T&  const_reference;
+	typedef T         value_type;
+
+	template <class U> struct rebind {
+		typedef throwing_allocator<U> other;
+	};
+
+	throwing_allocator() {}
+	template <class U> throwing_allocator(const throwing_allocator<U>&) {}
+
+	T* allocate(size_t n, const void* = 0)
+	{
+		if (++allocs == fail_at)
+			throw bad_alloc();
+		T* p = (T*)malloc(n * sizeof(T));
+		live[nlive++] = p;
+		return p;
+	}
+	void deallocate(T* p, size_t)
+	{
+		for (int i = 0; i < nlive; i++) {
+			if (live[i] == p) {
+				live[i] = live[--nlive];
+				free(p);
+				return;
+			}
+		}
+		bad_free = true;
+	}
+	size_t max_size() const { return size_t(-1) / sizeof(T); }
+	void construct(T* p, const T& v) { new(p) T(v); }
+	void destroy(T* p) { p->~T(); }
+};
+
+template <class T, class U>
+bool operator==(const throwing_allocator<T>&, const throwing_allocator<U>&) { return true; }
+template <class T, class U>
+bool operator!=(const throwing_allocator<T>&, const throwing_allocator<U>&) { return false; }
+
+int keys[N];
+
+// expected: 插入两遍之后的元素个数. 返回出错的次数
+template <class Container>
+int check(const char* name, size_t expected)
+{
+	int errors = 0;
+	for (int k = 1; ; k++) {
+		bool thrown = false;
+		{
+			Container c;
+			allocs = 0;
+			fail_at = k;
+			try {
+				c.insert(keys, keys + N);
+			} catch (bad_alloc&) {
+				thrown = true;
+			}
+			fail_at = 0;
+			size_t n = 0;
+			for (typename Container::iterator it = c.begin(); it != c.end(); ++it)
+				n++;
+			if (n != c.size()) {
+				printf("%s: 第 %d 次分配抛异常后 size() 是 %d, 实际有 %d 个\n",
+				       name, k, (int)c.size(), (int)n);
+				errors++;
+			}
+			c.insert(keys, keys + N);
+			if (!thrown && c.size() != expected) {
+				printf("%s: 插入两遍后有 %d 个, 应该是 %d 个\n",
+				       name, (int)c.size(), (int)expected);
+				errors++;
+			}
+		}
+		if (nlive != 0 || bad_free) {
+			printf("%s: 第 %d 次分配抛异常后, %d 个块没归还%s\n", name, k, nlive,
+			       bad_free ? ", 还归还了没分配过的块" : "");
+			errors++;
+			nlive = 0;
+			bad_free = false;
+		}
+		if (!thrown) {
+			printf("%s: 试了 %d 个抛异常的位置\n", name, k - 1);
+			return errors;
+		}
+	}
+}
+
+int main()
+{
+	for (int i = 0; i < N; i++)
+		keys[i] = i % DISTINCT * 7919 % 1000;
+
+	typedef throwing_allocator<int> A;
+	int errors = 0;
+	errors += check<set<int, less<int>, A> >("set", DISTINCT);
+	errors += check<multiset<int, less<int>, A> >("multiset", 2 * N);
+	errors += check<hash_set<int, hash<int>, equal_to<int>, A> >("hash_set", DISTINCT);
+	errors += check<hash_multiset<int, hash<int>, equal_to<int>, A> >("hash_multiset", 2 * N);
+	printf(errors ? "失败\n" : "通过\n");
+	return errors != 0;
+}
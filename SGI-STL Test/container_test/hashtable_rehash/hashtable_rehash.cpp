@@ -0,0 +1,175 @@
+// stl_config.h 只认识 gcc 2.x, 现代 g++ 的这些特性要手动打开
+#define __STL_CLASS_PARTIAL_SPECIALIZATION
+#define __STL_FUNCTION_TMPL_PARTIAL_ORDER
+#define __STL_EXPLICIT_FUNCTION_TMPL_ARGS
+#define __STL_MEMBER_TEMPLATES
+#define __STL_MEMBER_TEMPLATE_CLASSES
+#define __STL_TEMPLATE_FRIENDS
+#define __STL_HASHTABLE_INCREMENTAL_REHASH
+#include <stl_config.h>
+#include <stl_alloc.h>
+#include <stl_algobase.h>
+#include <stl_construct.h>
+#include <stl_uninitialized.h>
+#include <stl_tempbuf.h>
+#include <stl_algo.h>
+#include <stl_function.h>
+#include <stl_tree.h>
+#include <stl_multiset.h>
+#include <stl_vector.h>
+#include <stl_hash_fun.h>
+#include <stl_hashtable.h>
+#include <stl_hash_set.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace std;
+
+// __STL_HASHTABLE_INCREMENTAL_REHASH: 表变大时旧桶和新桶并存,
+// 每次插入只搬几个旧桶. 随机地插入, 删除, 查找, 遍历, 拷贝,
+// 每一步都和 multiset 对照, 大部分操作发生在搬迁的中途.
+// 另外检查: 区间插入让表变大很多时, 一次搬完, 不把元素都堆在旧桶里.
+// 编译: g++ -O2 -idirafter "../../../SGI-STL V3.3" hashtable_rehash.cpp
+// (用 SGI STL 3.3 支持的编译器; g++ 3.4 起要先给 stl_tree.h, stl_vector.h
+//  里用到基类成员的地方加上 this->)
+
+typedef hash_multiset<int> Table;
+typedef multiset<int> Reference;
+
+const int ROUNDS = 50;
+const int STEPS = 1000;
+const int KEYS = 3000;
+
+int errors;
+int in_rehash;              // 发生在搬迁中途的操作数
+
+void fail(int round, int step, const char* what)
+{
+	if (errors++ < 10)
+		printf("第 %d 轮第 %d 步: %s\n", round, step, what);
+}
+
+// 搬迁中途, 新桶里的元素比 size() 少
+bool rehashing(const Table& t)
+{
+	size_t n = 0;
+	for (size_t b = 0; b < t.bucket_count(); b++)
+		n += t.elems_in_bucket(b);
+	return n < t.size();
+}
+
+// 遍历得到的元素排好序后和 multiset 一样, 相同的 key 挨在一起
+bool same(const Table& t, const Reference& r)
+{
+	if (t.size() != r.size()) return false;
+	vector<int> v;
+	size_t runs = 0;
+	for (Table::const_iterator i = t.begin(); i != t.end(); ++i) {
+		if (v.empty() || v.back() != *i) runs++;
+		v.push_back(*i);
+	}
+	if (v.size() != r.size()) return false;
+	// 相同的 key 挨在一起, 段数就等于不同的 key 的个数
+	size_t keys = 0;
+	for (Reference::const_iterator j = r.begin(); j != r.end(); j = r.upper_bound(*j))
+		keys++;
+	if (runs != keys) return false;
+	sort(v.begin(), v.end());
+	return equal(v.begin(), v.end(), r.begin());
+}
+
+void random_ops(int round)
+{
+	Table t;
+	Reference r;
+	for (int step = 0; step < STEPS; step++) {
+		if (rehashing(t)) in_rehash++;
+		int key = rand() % KEYS;
+		switch (rand() % 8) {
+		case 0: case 1: case 2:
+			t.insert(key);
+			r.insert(key);
+			break;
+		case 3: {
+			// 小的区间, 不至于一次搬完
+			int keys[5];
+			for (int i = 0; i < 5; i++) keys[i] = rand() % KEYS;
+			t.insert(keys, keys + 5);
+			r.insert(keys, keys + 5);
+			break;
+		}
+		case 4:
+			if (t.erase(key) != r.erase(key))
+				fail(round, step, "erase(key) 删除的个数不对");
+			break;
+		case 5: {
+			Table::iterator i = t.find(key);
+			Reference::iterator j = r.find(key);
+			if ((i == t.end()) != (j == r.end()) || (i != t.end() && *i != key))
+				fail(round, step, "find 不对");
+			else if (i != t.end()) {
+				t.erase(i);
+				r.erase(j);
+			}
+			break;
+		}
+		case 6: {
+			if (t.count(key) != r.count(key))
+				fail(round, step, "count 不对");
+			pair<Table::iterator, Table::iterator> p = t.equal_range(key);
+			size_t n = 0;
+			for ( ; p.first != p.second; ++p.first, ++n)
+				if (*p.first != key)
+					fail(round, step, "equal_range 里有别的 key");
+			if (n != r.count(key))
+				fail(round, step, "equal_range 的长度不对");
+			break;
+		}
+		case 7: {
+			Table c(t);
+			if (!same(c, r))
+				fail(round, step, "拷贝出来的表不对");
+			if (!(c == t))
+				fail(round, step, "拷贝出来的表和原来的不相等");
+			break;
+		}
+		}
+		if (step % 50 == 0 && !same(t, r))
+			fail(round, step, "遍历的结果和 multiset 不一样");
+	}
+	if (!same(t, r))
+		fail(round, STEPS, "遍历的结果和 multiset 不一样");
+	t.clear();
+	if (t.size() != 0 || t.begin() != t.end() || rehashing(t))
+		fail(round, STEPS, "clear 之后不空");
+}
+
+// 区间插入把表撑大很多倍: 结束时所有元素都该在新桶里
+void bulk_insert()
+{
+	static int keys[100000];
+	for (int i = 0; i < 100000; i++) keys[i] = i;
+	Table t;
+	t.insert(-1);
+	t.insert(keys, keys + 100000);
+	if (t.size() != 100001 || rehashing(t))
+		fail(0, 0, "区间插入之后还有元素留在旧桶里");
+	for (int i = 0; i < 100000; i += 997)
+		if (t.find(i) == t.end())
+			fail(0, 0, "区间插入的元素找不到");
+}
+
+int main()
+{
+	srand(20260418);
+	for (int round = 0; round < ROUNDS; round++)
+		random_ops(round);
+	bulk_insert();
+	// 保证测到了搬迁中途的情况
+	if (in_rehash < ROUNDS * STEPS / 20) {
+		printf("只有 %d 个操作发生在搬迁中途\n", in_rehash);
+		errors++;
+	}
+	printf(errors ? "失败\n" : "通过\n");
+	return errors != 0;
+}
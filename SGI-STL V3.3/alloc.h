@@ -28,6 +28,9 @@ using __STD::malloc_alloc;
 using __STD::simple_alloc; 
 using __STD::debug_alloc; 
 using __STD::__default_alloc_template; 
+#ifdef __STL_NODE_ALLOCATOR_SHARDED
+using __STD::__sharded_alloc_template; 
+#endif /* __STL_NODE_ALLOCATOR_SHARDED */
 using __STD::alloc; 
 using __STD::single_client_alloc; 
 #ifdef __STL_STATIC_TEMPLATE_MEMBER_BUG
@@ -88,6 +88,134 @@
 #   define __NODE_ALLOCATOR_THREADS false
 #endif
 
+// Per-thread caches in front of the shared free lists need thread
+// specific data; we only know how to get that from pthreads.
+#if defined(__STL_NODE_ALLOCATOR_THREAD_CACHE) && !defined(__STL_PTHREADS)
+#   undef __STL_NODE_ALLOCATOR_THREAD_CACHE
+#endif
+
+// Shards tell threads apart with pthread_self, and find the shard a
+// freed object belongs to from the header of its chunk, which only
+// trimming mode keeps.  They replace the other two ways of spreading
+// the lock, rather than stacking on them.
+#if defined(__STL_NODE_ALLOCATOR_SHARDED) && \
+    (!defined(__STL_PTHREADS) || \
+     !defined(__STL_CLASS_PARTIAL_SPECIALIZATION) || \
+     !defined(__STL_MEMBER_TEMPLATES))
+#   undef __STL_NODE_ALLOCATOR_SHARDED
+#endif
+#ifdef __STL_NODE_ALLOCATOR_SHARDED
+#   if defined(__STL_NODE_ALLOCATOR_THREAD_CACHE) || \
+       defined(__STL_NODE_ALLOCATOR_LOCK_FREE)
+#       error __STL_NODE_ALLOCATOR_SHARDED cannot be combined with \
+              __STL_NODE_ALLOCATOR_THREAD_CACHE or \
+              __STL_NODE_ALLOCATOR_LOCK_FREE
+#   endif
+#   ifndef __STL_NODE_ALLOCATOR_TRIM
+#       define __STL_NODE_ALLOCATOR_TRIM
+#   endif
+#   ifndef __STL_NODE_ALLOCATOR_SHARDS
+#       define __STL_NODE_ALLOCATOR_SHARDS 8
+#   endif
+#endif
+
+// Lock-free free lists need a double-width compare-and-swap.  They also
+// rely on free objects staying mapped, which trimming does not allow.
+#if defined(__STL_NODE_ALLOCATOR_LOCK_FREE) && \
+    (!defined(__STL_THREADS) || !defined(__STL_HAS_DOUBLE_WIDTH_CAS))
+#   undef __STL_NODE_ALLOCATOR_LOCK_FREE
+#endif
+#if defined(__STL_NODE_ALLOCATOR_LOCK_FREE) && \
+    defined(__STL_NODE_ALLOCATOR_TRIM)
+#   error __STL_NODE_ALLOCATOR_LOCK_FREE and __STL_NODE_ALLOCATOR_TRIM \
+          cannot be used together
+#endif
+
+#ifdef __STL_HAS_MMAP
+#   include <sys/mman.h>
+#   include <unistd.h>
+#endif
+#ifdef __STL_HAS_MALLOC_USABLE_SIZE
+#   include <malloc.h>
+#endif
+#ifndef __STL_DEFAULT_CHUNK_SOURCE
+#   ifdef __STL_USE_HUGE_PAGES
+#       define __STL_DEFAULT_CHUNK_SOURCE _Huge_page_chunk_source
+#   else
+#       define __STL_DEFAULT_CHUNK_SOURCE _Malloc_chunk_source
+#   endif
+#endif
+
+#if defined(__STL_DEBUG_ALLOC_GUARD_PAGES)
+#   ifndef __STL_HAS_MMAP
+#       undef __STL_DEBUG_ALLOC_GUARD_PAGES
+#   elif !defined(__STL_DEBUG_ALLOC_CHECKS)
+#       define __STL_DEBUG_ALLOC_CHECKS
+#   endif
+#endif
+#ifdef __STL_DEBUG_ALLOC_CHECKS
+#   include <stdio.h>
+#   ifndef __STL_DEBUG_ALLOC_REDZONE
+#       define __STL_DEBUG_ALLOC_REDZONE 16
+#   endif
+#   ifndef __STL_DEBUG_ALLOC_QUARANTINE
+#       define __STL_DEBUG_ALLOC_QUARANTINE (256 * 1024)
+#   endif
+#endif
+
+#if defined(__STL_NODE_ALLOCATOR_TRIM) && \
+    !defined(__STL_NODE_ALLOCATOR_CHUNK_BYTES)
+#   define __STL_NODE_ALLOCATOR_CHUNK_BYTES (64 * 1024)
+#endif
+
+// Statistics.  With __STL_ALLOC_STATS defined, the allocators below keep
+// counters that can be read with get_stats().  __STL_ALLOC_STAT(expr)
+// evaluates expr only in that mode, so the counters cost nothing
+// otherwise.
+#ifdef __STL_ALLOC_STATS
+#   define __STL_ALLOC_STAT(__expr) __expr
+#else
+#   define __STL_ALLOC_STAT(__expr)
+#endif
+
+// Allocation sampling.  With __STL_ALLOC_SAMPLING defined, simple_alloc
+// and the standard allocators report their blocks to alloc_sampler
+// below.  __STL_ALLOC_SAMPLE(expr) evaluates expr only in that mode.
+// The sampler needs backtrace(), and thread specific data from pthreads
+// when threads are in use.
+#if defined(__STL_ALLOC_SAMPLING) && \
+    (!defined(__STL_HAS_BACKTRACE) || \
+     (defined(__STL_THREADS) && !defined(__STL_PTHREADS)))
+#   undef __STL_ALLOC_SAMPLING
+#endif
+#ifdef __STL_ALLOC_SAMPLING
+#   include <stdio.h>
+#   include <math.h>
+#   include <execinfo.h>
+#   ifndef __STL_ALLOC_SAMPLE_PERIOD
+#       define __STL_ALLOC_SAMPLE_PERIOD (512 * 1024)
+#   endif
+#   define __STL_ALLOC_SAMPLE(__expr) __expr
+#else
+#   define __STL_ALLOC_SAMPLE(__expr)
+#endif
+
+// Allocation tracing.  With __STL_ALLOC_TRACING defined, the node
+// allocator reports every request to alloc_tracer below.
+// __STL_ALLOC_TRACE(expr) evaluates expr only in that mode.  The tracer
+// keeps its buffers in thread specific data, so it needs pthreads when
+// threads are in use.
+#if defined(__STL_ALLOC_TRACING) && \
+    defined(__STL_THREADS) && !defined(__STL_PTHREADS)
+#   undef __STL_ALLOC_TRACING
+#endif
+#ifdef __STL_ALLOC_TRACING
+#   include <stdio.h>
+#   define __STL_ALLOC_TRACE(__expr) __expr
+#else
+#   define __STL_ALLOC_TRACE(__expr)
+#endif
+
 __STL_BEGIN_NAMESPACE
 
 #if defined(__sgi) && !defined(__GNUC__) && (_MIPS_SIM != _MIPS_SIM_ABI32)
@@ -104,6 +232,366 @@ __STL_BEGIN_NAMESPACE
     extern void (* __malloc_alloc_oom_handler)();
 # endif
 #endif
+
+#if defined(__STL_ALLOC_STATS) || defined(__STL_DEBUG_ALLOC_CHECKS)
+// Counters that are updated without holding a lock.  They are exact
+// when the compiler gives us an atomic add, and approximate otherwise.
+inline void __stl_stat_add(size_t* __p, size_t __n)
+{
+# if defined(__STL_THREADS) && defined(__GNUC__)
+    __sync_fetch_and_add(__p, __n);
+# else
+    *__p += __n;
+# endif
+}
+#endif /* __STL_ALLOC_STATS || __STL_DEBUG_ALLOC_CHECKS */
+
+// Aligned blocks straight from the C library.  __align must be a power
+// of 2 and a multiple of sizeof(void*).  Returns 0 on failure; the
+// result must be released with __stl_aligned_free.
+inline void* __stl_aligned_malloc(size_t __n, size_t __align)
+{
+# ifdef __STL_HAS_POSIX_MEMALIGN
+    void* __result;
+    if (0 != posix_memalign(&__result, __align, __n)) return 0;
+    return __result;
+# else
+    // Over-allocate and remember the real block just below the result.
+    char* __real_p = (char*)malloc(__n + __align);
+    if (0 == __real_p) return 0;
+    char* __result = (char*)(((size_t)__real_p + __align) & ~(__align - 1));
+    ((void**)__result)[-1] = __real_p;
+    return __result;
+# endif
+}
+
+inline void __stl_aligned_free(void* __p)
+{
+# ifdef __STL_HAS_POSIX_MEMALIGN
+    free(__p);
+# else
+    free(((void**)__p)[-1]);
+# endif
+}
+
+// Bytes that the block __p, obtained from malloc for __n bytes, can
+// hold without moving; __n if the C library cannot tell.  The bytes
+// past __n are not the caller's until a realloc claims them, and that
+// realloc may move the block.
+inline size_t __stl_malloc_usable_size(void* __p, size_t __n)
+{
+# ifdef __STL_HAS_MALLOC_USABLE_SIZE
+    size_t __usable = malloc_usable_size(__p);
+    return __usable < __n ? __n : __usable;
+# else
+    return __n;
+# endif
+}
+
+// Chunk sources.  The pool allocators carve their objects out of large
+// chunks, and a chunk source is where the chunks come from.  It has
+//   _S_good_size(__n): the size to ask for when at least __n bytes are
+//     wanted; the pool then uses all of it.
+//   _S_allocate(__n, __align): __n bytes aligned on __align (a power of
+//     2, or 0 for no particular alignment), or 0 on failure.  The pool
+//     then falls back on malloc_alloc and its out-of-memory handler.
+//   _S_deallocate(__p, __n, __align): gives back a block obtained with
+//     the same __n and __align.
+// 内存池的chunk从哪里来: malloc, 或者2M大页
+
+struct _Malloc_chunk_source {
+  static size_t _S_good_size(size_t __n) { return __n; }
+  static void* _S_allocate(size_t __n, size_t __align)
+    { return 0 == __align ? malloc(__n) : __stl_aligned_malloc(__n, __align); }
+  static void _S_deallocate(void* __p, size_t, size_t __align)
+    { if (0 == __align) free(__p); else __stl_aligned_free(__p); }
+};
+
+// Blocks are mapped directly, aligned on 2 MiB, and advised with
+// MADV_HUGEPAGE, so that the kernel can back each 2 MiB of a chunk with
+// one huge page, and a large node population needs few TLB entries.
+// Unaligned requests are rounded up to whole huge pages.  Without mmap
+// this degrades to aligned malloc.
+struct _Huge_page_chunk_source {
+  enum {_S_HUGE_PAGE_BYTES = 2 * 1024 * 1024};
+
+  static size_t _S_good_size(size_t __n) {
+    return (__n + (size_t) _S_HUGE_PAGE_BYTES - 1)
+           & ~((size_t) _S_HUGE_PAGE_BYTES - 1);
+  }
+  static void* _S_allocate(size_t __n, size_t __align) {
+    if (__align < (size_t) _S_HUGE_PAGE_BYTES)
+      __align = (size_t) _S_HUGE_PAGE_BYTES;
+# ifdef __STL_HAS_MMAP
+    // Map __align bytes too many, then unmap the slop on either side of
+    // the aligned block.
+    size_t __len = _S_page_round(__n);
+    char* __map = (char*) mmap(0, __len + __align, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == (void*) __map) return 0;
+    char* __result = (char*)(((size_t)__map + __align - 1) & ~(__align - 1));
+    size_t __head = __result - __map;
+    if (0 != __head)
+      munmap(__map, __head);
+    if (__align != __head)
+      munmap(__result + __len, __align - __head);
+#   ifdef MADV_HUGEPAGE
+    madvise(__result, __len, MADV_HUGEPAGE);
+#   endif
+    return __result;
+# else
+    return __stl_aligned_malloc(__n, __align);
+# endif
+  }
+  static void _S_deallocate(void* __p, size_t __n, size_t) {
+# ifdef __STL_HAS_MMAP
+    munmap(__p, _S_page_round(__n));
+# else
+    __stl_aligned_free(__p);
+# endif
+  }
+# ifdef __STL_HAS_MMAP
+  static size_t _S_page_round(size_t __n) {
+    size_t __page = (size_t) sysconf(_SC_PAGESIZE);
+    return (__n + __page - 1) & ~(__page - 1);
+  }
+# endif
+};
+
+// Memory pressure.
+// Parts of a program that hold memory they could give up, such as
+// caches, oversized hashtables and the allocators' own pools, register
+// shrink callbacks here.  release(__bytes) calls them in order of
+// increasing priority, asking each for the bytes still wanted, until
+// __bytes have been released or every callback has been asked.
+// malloc_alloc does this before it resorts to the out-of-memory
+// handler, and programs may call it themselves, e.g. on a low-memory
+// notification.
+// A callback is passed the number of bytes wanted and the argument it
+// was registered with, and returns the number of bytes it actually
+// gave back, which may be more or less than asked.  It must not throw,
+// nor remove callbacks.  It may allocate, but an allocation that fails
+// while the callbacks run gets no help from them.  Callbacks it adds,
+// e.g. from an allocator growing for the first time, are held back
+// until the others have run.
+// 内存压力: 注册收缩回调, 按优先级依次调用直到释放够目标字节数
+
+typedef size_t (*__stl_shrink_callback)(size_t __bytes, void* __arg);
+
+template <int __inst>
+class __memory_pressure_template {
+private:
+  enum {_S_MAX_CALLBACKS = 32};
+  struct _Entry {
+    __stl_shrink_callback _M_fn;
+    void* _M_arg;
+    int _M_priority;
+  };
+
+  static _Entry _S_entries[_S_MAX_CALLBACKS];   // Sorted by priority.
+  static int _S_count;
+  // Added while release runs, which holds _S_lock meanwhile.
+  static _Entry _S_pending[_S_MAX_CALLBACKS];
+  static int _S_pending_count;
+  static bool __STL_VOLATILE _S_releasing;
+# ifdef __STL_THREADS
+  // Guards the callbacks, and is held while they run.
+  static _STL_mutex_lock _S_lock;
+  // Guards the pending callbacks, and the clearing of _S_releasing.
+  static _STL_mutex_lock _S_pending_lock;
+# endif
+# ifdef __STL_PTHREADS
+  static pthread_t _S_releasing_thread;
+# endif
+
+  // Whether an add must wait for release to finish.  Under thread
+  // packages other than pthreads we cannot tell a callback's add from
+  // another thread's, so those wait as well.
+  static bool _S_deferring() {
+#   ifdef __STL_PTHREADS
+    return _S_releasing && pthread_equal(_S_releasing_thread, pthread_self());
+#   else
+    return _S_releasing;
+#   endif
+  }
+  static bool _S_add(_Entry* __entries, int& __count, int __room,
+                     __stl_shrink_callback __fn, void* __arg,
+                     int __priority);
+
+public:
+  // Suggested priorities.  Cheap caches go first; pools go last, since
+  // the others free into them.
+  enum { priority_cache = 100, priority_container = 200,
+         priority_pool = 300 };
+
+  // Registers __fn with __arg.  Registering the same pair again only
+  // changes its priority.  Returns false if there is no room.
+  static bool add_shrink_callback(__stl_shrink_callback __fn, void* __arg,
+                                  int __priority);
+  // Once this returns, __fn is not running and will not be called with
+  // __arg again.
+  static void remove_shrink_callback(__stl_shrink_callback __fn,
+                                     void* __arg);
+
+  // Asks the callbacks for __bytes bytes, and returns the number they
+  // gave back.  Returns 0 at once if called from a callback.
+  static size_t release(size_t __bytes);
+};
+
+typedef __memory_pressure_template<0> memory_pressure;
+
+template <int __inst>
+typename __memory_pressure_template<__inst>::_Entry
+__memory_pressure_template<__inst>::_S_entries[
+  __memory_pressure_template<__inst>::_S_MAX_CALLBACKS];
+template <int __inst>
+int __memory_pressure_template<__inst>::_S_count = 0;
+template <int __inst>
+typename __memory_pressure_template<__inst>::_Entry
+__memory_pressure_template<__inst>::_S_pending[
+  __memory_pressure_template<__inst>::_S_MAX_CALLBACKS];
+template <int __inst>
+int __memory_pressure_template<__inst>::_S_pending_count = 0;
+template <int __inst>
+bool __STL_VOLATILE __memory_pressure_template<__inst>::_S_releasing = false;
+#ifdef __STL_THREADS
+template <int __inst>
+_STL_mutex_lock
+__memory_pressure_template<__inst>::_S_lock __STL_MUTEX_INITIALIZER;
+template <int __inst>
+_STL_mutex_lock
+__memory_pressure_template<__inst>::_S_pending_lock __STL_MUTEX_INITIALIZER;
+#endif
+#ifdef __STL_PTHREADS
+template <int __inst>
+pthread_t __memory_pressure_template<__inst>::_S_releasing_thread;
+#endif
+
+// Puts (__fn, __arg) into __entries, which holds __count of them
+// sorted by priority, unless that would make more than __room.
+template <int __inst>
+bool
+__memory_pressure_template<__inst>::_S_add(
+  _Entry* __entries, int& __count, int __room,
+  __stl_shrink_callback __fn, void* __arg, int __priority)
+{
+    int __i;
+    for (__i = 0; __i < __count; ++__i)
+      if (__entries[__i]._M_fn == __fn && __entries[__i]._M_arg == __arg)
+        break;
+    if (__i < __count) {
+      // Take it out, and put it back in its new place below.
+      for (; __i + 1 < __count; ++__i)
+        __entries[__i] = __entries[__i + 1];
+      --__count;
+    } else if (__count >= __room) {
+      return false;
+    }
+    // After any others of the same priority.
+    for (__i = __count;
+         __i > 0 && __entries[__i - 1]._M_priority > __priority; --__i)
+      __entries[__i] = __entries[__i - 1];
+    __entries[__i]._M_fn = __fn;
+    __entries[__i]._M_arg = __arg;
+    __entries[__i]._M_priority = __priority;
+    ++__count;
+    return true;
+}
+
+template <int __inst>
+bool
+__memory_pressure_template<__inst>::add_shrink_callback(
+  __stl_shrink_callback __fn, void* __arg, int __priority)
+{
+    // From a callback _S_lock is ours already, and taking it again
+    // would hang; release adds the pending ones once the others ran.
+    {
+#     ifdef __STL_THREADS
+      /*REFERENCED*/
+      _STL_auto_lock __pending_instance(_S_pending_lock);
+#     endif
+      if (_S_deferring())
+        return _S_add(_S_pending, _S_pending_count,
+                      (int) _S_MAX_CALLBACKS - _S_count,
+                      __fn, __arg, __priority);
+    }
+# ifdef __STL_THREADS
+    /*REFERENCED*/
+    _STL_auto_lock __lock_instance(_S_lock);
+# endif
+    return _S_add(_S_entries, _S_count, (int) _S_MAX_CALLBACKS,
+                  __fn, __arg, __priority);
+}
+
+template <int __inst>
+void
+__memory_pressure_template<__inst>::remove_shrink_callback(
+  __stl_shrink_callback __fn, void* __arg)
+{
+# ifdef __STL_THREADS
+    /*REFERENCED*/
+    _STL_auto_lock __lock_instance(_S_lock);
+# endif
+    for (int __i = 0; __i < _S_count; ++__i) {
+      if (_S_entries[__i]._M_fn == __fn && _S_entries[__i]._M_arg == __arg) {
+        for (; __i + 1 < _S_count; ++__i)
+          _S_entries[__i] = _S_entries[__i + 1];
+        --_S_count;
+        return;
+      }
+    }
+}
+
+template <int __inst>
+size_t __memory_pressure_template<__inst>::release(size_t __bytes)
+{
+    // One thread reclaims at a time; others wait for it, and then ask
+    // for what they still need.  Under thread packages other than
+    // pthreads we cannot tell a callback's own allocation from another
+    // thread's, so those give up instead of waiting.
+# if defined(__STL_PTHREADS)
+    if (_S_releasing && pthread_equal(_S_releasing_thread, pthread_self()))
+      return 0;
+    _S_lock._M_acquire_lock();
+# elif defined(__STL_THREADS)
+    if (!_S_lock._M_try_acquire_lock())
+      return 0;
+# else
+    if (_S_releasing)
+      return 0;
+# endif
+    {
+#     ifdef __STL_THREADS
+      /*REFERENCED*/
+      _STL_auto_lock __pending_instance(_S_pending_lock);
+#     endif
+#     ifdef __STL_PTHREADS
+      _S_releasing_thread = pthread_self();
+#     endif
+      _S_releasing = true;
+    }
+    size_t __released = 0;
+    for (int __i = 0; __i < _S_count && __released < __bytes; ++__i)
+      __released += (*_S_entries[__i]._M_fn)(__bytes - __released,
+                                             _S_entries[__i]._M_arg);
+    {
+#     ifdef __STL_THREADS
+      /*REFERENCED*/
+      _STL_auto_lock __pending_instance(_S_pending_lock);
+#     endif
+      for (int __j = 0; __j < _S_pending_count; ++__j)
+        _S_add(_S_entries, _S_count, (int) _S_MAX_CALLBACKS,
+               _S_pending[__j]._M_fn, _S_pending[__j]._M_arg,
+               _S_pending[__j]._M_priority);
+      _S_pending_count = 0;
+      _S_releasing = false;
+    }
+# ifdef __STL_THREADS
+    _S_lock._M_release_lock();
+# endif
+    return __released;
+}
+
 /**
  * 一级适配器
  * 线程安全 
@@ -116,31 +604,114 @@ private:
   // 处理内存不足的情况
   static void* _S_oom_malloc(size_t);
   static void* _S_oom_realloc(void*, size_t);
+  static void* _S_oom_aligned_malloc(size_t, size_t);
 
 #ifndef __STL_STATIC_TEMPLATE_MEMBER_BUG
   static void (* __malloc_alloc_oom_handler)();
 #endif
 
 public:
+# ifdef __STL_ALLOC_STATS
+  struct stats_type {
+    size_t _M_allocs;            // allocate and allocate_aligned calls
+    size_t _M_frees;             // deallocate and deallocate_aligned calls
+    size_t _M_reallocs;
+    size_t _M_bytes_allocated;   // total requested, including reallocate
+    size_t _M_bytes_freed;       // total given back, as reported by callers
+    size_t _M_oom_handler_calls; // out-of-memory handler invocations
+  };
+  static void get_stats(stats_type& __s) { __s = _S_stats; }
+private:
+  static stats_type _S_stats;
+public:
+# endif /* __STL_ALLOC_STATS */
 
   static void* allocate(size_t __n)
   {
     void* __result = malloc(__n);
     if (0 == __result) __result = _S_oom_malloc(__n);
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_allocs, 1));
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_bytes_allocated, __n));
     return __result;
   }
 
+# ifdef __STL_ALLOC_STATS
+  static void deallocate(void* __p, size_t __n)
+  {
+    free(__p);
+    __stl_stat_add(&_S_stats._M_frees, 1);
+    __stl_stat_add(&_S_stats._M_bytes_freed, __n);
+  }
+
+  static void* reallocate(void* __p, size_t __old_sz, size_t __new_sz)
+  {
+    void* __result = realloc(__p, __new_sz);
+    if (0 == __result) __result = _S_oom_realloc(__p, __new_sz);
+    __stl_stat_add(&_S_stats._M_reallocs, 1);
+    __stl_stat_add(&_S_stats._M_bytes_allocated, __new_sz);
+    __stl_stat_add(&_S_stats._M_bytes_freed, __old_sz);
+    return __result;
+  }
+# else /* __STL_ALLOC_STATS */
   static void deallocate(void* __p, size_t /* __n */)
   {
     free(__p);
   }
 
-  static void* reallocate(void* __p, size_t /* old_sz */, size_t __new_sz)
+  static void* reallocate(void* __p, size_t /* __old_sz */, size_t __new_sz)
   {
     void* __result = realloc(__p, __new_sz);
     if (0 == __result) __result = _S_oom_realloc(__p, __new_sz);
     return __result;
   }
+# endif /* __STL_ALLOC_STATS */
+
+  // __align must be a power of 2 and a multiple of sizeof(void*).
+  // Blocks from allocate_aligned must be returned to deallocate_aligned.
+  static void* allocate_aligned(size_t __n, size_t __align)
+  {
+    void* __result = __stl_aligned_malloc(__n, __align);
+    if (0 == __result) __result = _S_oom_aligned_malloc(__n, __align);
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_allocs, 1));
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_bytes_allocated, __n));
+    return __result;
+  }
+
+# ifdef __STL_ALLOC_STATS
+  static void deallocate_aligned(void* __p, size_t __n, size_t = 0)
+  {
+    __stl_aligned_free(__p);
+    __stl_stat_add(&_S_stats._M_frees, 1);
+    __stl_stat_add(&_S_stats._M_bytes_freed, __n);
+  }
+# else /* __STL_ALLOC_STATS */
+  static void deallocate_aligned(void* __p, size_t /* __n */, size_t = 0)
+  {
+    __stl_aligned_free(__p);
+  }
+# endif /* __STL_ALLOC_STATS */
+
+  // The extended protocol; see _Alloc_extensions below.
+  // allocate_at_least claims malloc's slack with realloc before it
+  // reports it, and keeps whatever block realloc answers.
+  static void* allocate_at_least(size_t __n, size_t& __got)
+  {
+    void* __result = allocate(__n);
+    __got = __stl_malloc_usable_size(__result, __n);
+    if (__got != __n) {
+      void* __claimed = realloc(__result, __got);
+      if (0 == __claimed) __got = __n; else __result = __claimed;
+    }
+    return __result;
+  }
+
+  // Growing past __old_sz would take a realloc, which may move the
+  // block, so only a block allocate_at_least already claimed in full
+  // can take a larger size in place.
+  static bool try_expand(void* /* __p */, size_t __old_sz, size_t __new_sz)
+  {
+    return __new_sz <= __old_sz;
+  }
 // 指定自己的out_of_mem_handler, public
   static void (* __set_malloc_handler(void (*__f)()))()
   {
@@ -158,6 +729,12 @@ template <int __inst>
 void (* __malloc_alloc_template<__inst>::__malloc_alloc_oom_handler)() = 0; // handler函数初始值设为0
 #endif
 
+#ifdef __STL_ALLOC_STATS
+template <int __inst>
+typename __malloc_alloc_template<__inst>::stats_type
+__malloc_alloc_template<__inst>::_S_stats;
+#endif
+
 template <int __inst>
 void*
 __malloc_alloc_template<__inst>::_S_oom_malloc(size_t __n)
@@ -166,9 +743,15 @@ __malloc_alloc_template<__inst>::_S_oom_malloc(size_t __n)
     void* __result;
 
     for (;;) { // 不断的尝试
-        __my_malloc_handler = __malloc_alloc_oom_handler;
-        if (0 == __my_malloc_handler) { __THROW_BAD_ALLOC; }
-        (*__my_malloc_handler)();// 调用自定义handler释放内存
+        // The shrink callbacks first, and the handler only once they
+        // have nothing more to give.
+        if (0 == memory_pressure::release(__n)) {
+            __my_malloc_handler = __malloc_alloc_oom_handler;
+            if (0 == __my_malloc_handler) { __THROW_BAD_ALLOC; }
+            __STL_ALLOC_STAT(
+              __stl_stat_add(&_S_stats._M_oom_handler_calls, 1));
+            (*__my_malloc_handler)();// 调用自定义handler释放内存
+        }
         __result = malloc(__n); // 再次尝试配置内存
         if (__result) return(__result);
     }
@@ -181,16 +764,773 @@ void* __malloc_alloc_template<__inst>::_S_oom_realloc(void* __p, size_t __n)
     void* __result;
 
     for (;;) {
-        __my_malloc_handler = __malloc_alloc_oom_handler;
-        if (0 == __my_malloc_handler) { __THROW_BAD_ALLOC; }
-        (*__my_malloc_handler)();
+        if (0 == memory_pressure::release(__n)) {
+            __my_malloc_handler = __malloc_alloc_oom_handler;
+            if (0 == __my_malloc_handler) { __THROW_BAD_ALLOC; }
+            __STL_ALLOC_STAT(
+              __stl_stat_add(&_S_stats._M_oom_handler_calls, 1));
+            (*__my_malloc_handler)();
+        }
         __result = realloc(__p, __n); //
         if (__result) return(__result);
     }
 }
 
+template <int __inst>
+void* __malloc_alloc_template<__inst>::_S_oom_aligned_malloc(size_t __n,
+                                                             size_t __align)
+{
+    void (* __my_malloc_handler)();
+    void* __result;
+
+    for (;;) {
+        if (0 == memory_pressure::release(__n)) {
+            __my_malloc_handler = __malloc_alloc_oom_handler;
+            if (0 == __my_malloc_handler) { __THROW_BAD_ALLOC; }
+            __STL_ALLOC_STAT(
+              __stl_stat_add(&_S_stats._M_oom_handler_calls, 1));
+            (*__my_malloc_handler)();
+        }
+        __result = __stl_aligned_malloc(__n, __align);
+        if (__result) return(__result);
+    }
+}
+
 typedef __malloc_alloc_template<0> malloc_alloc; // __inst直接指定为0 实际上整个过程中我们并没有用到
 
+// The extended allocation protocol.  Besides allocate and deallocate,
+// an SGI-style allocator may offer
+//   allocate_at_least(__n, __got): at least __n bytes; sets __got to the
+//     number actually usable, which may be passed to deallocate.
+//   try_expand(__p, __old_sz, __new_sz): grows a block in place and
+//     answers whether it could; on success the block must later be
+//     deallocated as __new_sz bytes.  It never moves the block.
+//   allocate_aligned(__n, __align), deallocate_aligned(__p, __n, __align):
+//     a block aligned on __align, a power of 2.
+//   allocate_n_nodes(__n, __count, __out): __count blocks of __n bytes
+//     each, stored in __out[0] ... __out[__count - 1], for the price of
+//     one lock and at most one refill per batch.  Each is deallocated on
+//     its own.  If it throws, it has kept none of them.
+// _Alloc_extensions<_Alloc> calls them when _Alloc is known to have
+// them, and otherwise does the best it can with allocate and
+// deallocate.  Containers go through it (by way of simple_alloc) so
+// that they work with any allocator.  The fallbacks live in
+// _Alloc_generic_extensions, so that a specialization need only
+// supply what its allocator does better.
+// 扩展接口: 拿到round_up后的真实大小, 原地扩容, 对齐分配, 批量分配节点
+
+template <class _Alloc>
+struct _Alloc_generic_extensions {
+  static void* allocate_at_least(size_t __n, size_t& __got)
+    { __got = __n; return _Alloc::allocate(__n); }
+  static bool try_expand(void*, size_t, size_t) { return false; }
+  // Over-allocate and remember the real block just below the result.
+  static void* allocate_aligned(size_t __n, size_t __align) {
+    if (__align < sizeof(void*)) __align = sizeof(void*);
+    char* __real_p = (char*)_Alloc::allocate(__n + __align + sizeof(void*));
+    char* __result = (char*)
+      (((size_t)__real_p + sizeof(void*) + __align - 1) & ~(__align - 1));
+    ((void**)__result)[-1] = __real_p;
+    return __result;
+  }
+  static void deallocate_aligned(void* __p, size_t __n, size_t __align) {
+    if (__align < sizeof(void*)) __align = sizeof(void*);
+    _Alloc::deallocate(((void**)__p)[-1], __n + __align + sizeof(void*));
+  }
+  static void allocate_n_nodes(size_t __n, size_t __count, void** __out) {
+    size_t __i = 0;
+    __STL_TRY {
+      for ( ; __i < __count; ++__i)
+        __out[__i] = _Alloc::allocate(__n);
+    }
+    __STL_UNWIND(while (__i > 0) _Alloc::deallocate(__out[--__i], __n));
+  }
+};
+
+template <class _Alloc>
+struct _Alloc_extensions : public _Alloc_generic_extensions<_Alloc> {};
+
+#ifdef __STL_CLASS_PARTIAL_SPECIALIZATION
+
+template <int __inst>
+struct _Alloc_extensions<__malloc_alloc_template<__inst> >
+  : public _Alloc_generic_extensions<__malloc_alloc_template<__inst> > {
+  typedef __malloc_alloc_template<__inst> _Alloc;
+  static void* allocate_at_least(size_t __n, size_t& __got)
+    { return _Alloc::allocate_at_least(__n, __got); }
+  static bool try_expand(void* __p, size_t __old_sz, size_t __new_sz)
+    { return _Alloc::try_expand(__p, __old_sz, __new_sz); }
+  static void* allocate_aligned(size_t __n, size_t __align) {
+    if (__align < sizeof(void*)) __align = sizeof(void*);
+    return _Alloc::allocate_aligned(__n, __align);
+  }
+  static void deallocate_aligned(void* __p, size_t __n, size_t __align)
+    { _Alloc::deallocate_aligned(__p, __n, __align); }
+};
+
+#endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */
+
+#ifdef __STL_ALLOC_SAMPLING
+
+// Allocation-site sampling profiler.
+// Every block handed out by simple_alloc, allocator or __allocator
+// counts its bytes against a countdown kept per thread.  The block that
+// runs the countdown out is sampled: the call stack that asked for it
+// is recorded and charged to that call site, and the block is
+// remembered until it is freed.  Countdowns are drawn from an
+// exponential distribution with a mean of sample_period() bytes, so a
+// block of __n bytes is sampled with probability
+// 1 - exp(-__n / sample_period()), which is what pprof assumes when it
+// scales a heap_v2 profile back up.
+// write_heap_profile() writes, per call site, the sampled blocks still
+// live and all those sampled so far, in the text format pprof reads:
+//   alloc_sampler::dump_heap_profile("/tmp/app.heap");
+//   pprof --text ./app /tmp/app.heap
+// Blocks from the node allocator are charged to the container that
+// asked for them rather than to the pool they were carved from, so the
+// profile tells which maps and hash_maps hold the memory the pools keep.
+// An allocation that is not sampled costs a lookup of thread specific
+// data and a subtraction; a deallocation, one probe of a hash table
+// while any sampled block is live.  try_expand does not change the size
+// recorded for a sampled block.
+// 分配采样: 平均每 sample_period() 字节记录一次调用栈, 按调用点聚合,
+// 输出 pprof 可读的 heap profile.
+
+template <int __inst>
+class __alloc_sampler {
+private:
+  enum {_S_MAX_DEPTH = 32};
+  enum {_S_SITE_BUCKETS = 1024};        // Powers of 2.
+  enum {_S_LIVE_BUCKETS = 16384};
+
+  struct _Site {
+    _Site* _M_next;
+    size_t _M_hash;
+    int _M_depth;
+    void* _M_stack[_S_MAX_DEPTH];
+    size_t _M_allocs;                   // Blocks sampled here,
+    size_t _M_alloc_bytes;
+    size_t _M_live;                     // and those not yet freed.
+    size_t _M_live_bytes;
+  };
+  struct _Live {
+    _Live* _M_next;
+    void* _M_p;
+    size_t _M_bytes;
+    _Site* _M_site;
+  };
+  struct _Thread_state {
+    size_t _M_bytes_left;               // Until the next sample.
+    unsigned int _M_rand;
+  };
+
+  static size_t __STL_VOLATILE _S_period;
+  // Read without the lock, to let deallocation skip it.
+  static size_t __STL_VOLATILE _S_live_count;
+  static _Live* __STL_VOLATILE _S_live[_S_LIVE_BUCKETS];
+  static _Site* _S_sites[_S_SITE_BUCKETS];
+# ifdef __STL_THREADS
+  static _STL_mutex_lock _S_lock;       // Guards the tables.
+# endif
+# ifdef __STL_PTHREADS
+  static pthread_key_t _S_state_key;
+  static bool _S_state_key_initialized;
+# else
+  static _Thread_state _S_state;
+# endif
+
+  static size_t _S_live_index(void* __p) {
+    return (((size_t) __p >> 3) ^ ((size_t) __p >> 17))
+           & (_S_LIVE_BUCKETS - 1);
+  }
+
+  // Returns the calling thread's state, or 0 if it cannot be had; the
+  // allocation then simply goes unsampled.
+  static _Thread_state* _S_get_state() {
+# ifdef __STL_PTHREADS
+    _Thread_state* __s;
+    if (!_S_state_key_initialized ||
+        0 == (__s = (_Thread_state*) pthread_getspecific(_S_state_key)))
+      __s = _S_new_state();
+    return __s;
+# else
+    if (0 == _S_state._M_rand) _S_init_state(&_S_state);
+    return &_S_state;
+# endif
+  }
+# ifdef __STL_PTHREADS
+  static _Thread_state* _S_new_state();
+  static void _S_state_destructor(void* __s) { free(__s); }
+# endif
+  static void _S_init_state(_Thread_state* __s);
+  // An exponentially distributed number of bytes with mean _S_period.
+  static size_t _S_next_interval(_Thread_state* __s);
+  static void _S_sample(_Thread_state* __s, void* __p, size_t __n);
+  static void _S_forget(void* __p);
+  // Finds the site for the call stack __stack, adding it if need be.
+  // Called with the lock held.
+  static _Site* _S_find_site(void** __stack, int __depth);
+
+public:
+  // The mean number of bytes between samples; 0 turns sampling off.
+  // The default is __STL_ALLOC_SAMPLE_PERIOD (512K).
+  static size_t sample_period() { return _S_period; }
+  static void set_sample_period(size_t __bytes) { _S_period = __bytes; }
+
+  // Writes the profile to __f.  Safe to call while other threads
+  // allocate.
+  static void write_heap_profile(FILE* __f);
+  // Writes the profile to the file __path.  Returns false if it could
+  // not be written.
+  static bool dump_heap_profile(const char* __path);
+
+  // Called by simple_alloc and the allocators with every block they
+  // hand out, and with every block before it is returned.
+  static void _S_note_allocate(void* __p, size_t __n) {
+    if (0 == __p || 0 == _S_period) return;
+    _Thread_state* __s = _S_get_state();
+    if (0 == __s) return;
+    if (__n < __s->_M_bytes_left) {
+      __s->_M_bytes_left -= __n;
+      return;
+    }
+    _S_sample(__s, __p, __n);
+  }
+  static void _S_note_deallocate(void* __p) {
+    if (0 != _S_live_count && 0 != _S_live[_S_live_index(__p)])
+      _S_forget(__p);
+  }
+};
+
+typedef __alloc_sampler<0> alloc_sampler;
+
+template <int __inst>
+size_t __STL_VOLATILE __alloc_sampler<__inst>::_S_period
+  = __STL_ALLOC_SAMPLE_PERIOD;
+template <int __inst>
+size_t __STL_VOLATILE __alloc_sampler<__inst>::_S_live_count = 0;
+template <int __inst>
+typename __alloc_sampler<__inst>::_Live* __STL_VOLATILE
+__alloc_sampler<__inst>::_S_live[__alloc_sampler<__inst>::_S_LIVE_BUCKETS];
+template <int __inst>
+typename __alloc_sampler<__inst>::_Site*
+__alloc_sampler<__inst>::_S_sites[__alloc_sampler<__inst>::_S_SITE_BUCKETS];
+# ifdef __STL_THREADS
+template <int __inst>
+_STL_mutex_lock __alloc_sampler<__inst>::_S_lock __STL_MUTEX_INITIALIZER;
+# endif
+# ifdef __STL_PTHREADS
+template <int __inst>
+pthread_key_t __alloc_sampler<__inst>::_S_state_key;
+template <int __inst>
+bool __alloc_sampler<__inst>::_S_state_key_initialized = false;
+# else
+template <int __inst>
+typename __alloc_sampler<__inst>::_Thread_state
+__alloc_sampler<__inst>::_S_state;
+# endif
+
+# ifdef __STL_PTHREADS
+template <int __inst>
+typename __alloc_sampler<__inst>::_Thread_state*
+__alloc_sampler<__inst>::_S_new_state()
+{
+    {
+        /*REFERENCED*/
+        _STL_auto_lock __lock_instance(_S_lock);
+        if (!_S_state_key_initialized) {
+            if (pthread_key_create(&_S_state_key, _S_state_destructor))
+                return 0;
+            _S_state_key_initialized = true;
+        }
+    }
+    _Thread_state* __s = (_Thread_state*) malloc(sizeof(_Thread_state));
+    if (0 == __s) return 0;
+    if (pthread_setspecific(_S_state_key, __s)) {
+        free(__s);
+        return 0;
+    }
+    _S_init_state(__s);
+    return __s;
+}
+# endif
+
+template <int __inst>
+void __alloc_sampler<__inst>::_S_init_state(_Thread_state* __s)
+{
+    // Any nonzero seed will do; the state's address differs per thread.
+    __s->_M_rand = (unsigned int) ((size_t) __s >> 4) ^ 0x9e3779b9u;
+    if (0 == __s->_M_rand) __s->_M_rand = 1;
+    __s->_M_bytes_left = _S_next_interval(__s);
+}
+
+template <int __inst>
+size_t __alloc_sampler<__inst>::_S_next_interval(_Thread_state* __s)
+{
+    unsigned int __x = __s->_M_rand;    // xorshift32
+    __x ^= __x << 13;
+    __x ^= __x >> 17;
+    __x ^= __x << 5;
+    __s->_M_rand = __x;
+    // Uniform on (0, 1], from the top 24 bits.
+    double __u = ((__x >> 8) + 1) / 16777216.0;
+    return (size_t) (-log(__u) * (double) _S_period) + 1;
+}
+
+template <int __inst>
+void __alloc_sampler<__inst>::_S_sample(_Thread_state* __s, void* __p,
+                                        size_t __n)
+{
+    __s->_M_bytes_left = _S_next_interval(__s);
+
+    // The innermost frames belong to the sampler and the allocator;
+    // they are the same for every sample and cost nothing to keep.
+    void* __stack[_S_MAX_DEPTH];
+    int __depth = backtrace(__stack, _S_MAX_DEPTH);
+    if (__depth <= 0) return;
+
+# ifdef __STL_THREADS
+    /*REFERENCED*/
+    _STL_auto_lock __lock_instance(_S_lock);
+# endif
+    _Site* __site = _S_find_site(__stack, __depth);
+    if (0 == __site) return;
+    _Live* __l = (_Live*) malloc(sizeof(_Live));
+    if (0 == __l) return;
+    __l->_M_p = __p;
+    __l->_M_bytes = __n;
+    __l->_M_site = __site;
+    __l->_M_next = _S_live[_S_live_index(__p)];
+    _S_live[_S_live_index(__p)] = __l;
+    ++_S_live_count;
+    ++__site->_M_allocs;
+    __site->_M_alloc_bytes += __n;
+    ++__site->_M_live;
+    __site->_M_live_bytes += __n;
+}
+
+template <int __inst>
+void __alloc_sampler<__inst>::_S_forget(void* __p)
+{
+# ifdef __STL_THREADS
+    /*REFERENCED*/
+    _STL_auto_lock __lock_instance(_S_lock);
+# endif
+    _Live* __STL_VOLATILE* __link = _S_live + _S_live_index(__p);
+    for (_Live* __l = *__link; 0 != __l; __l = *__link) {
+      if (__l->_M_p == __p) {
+        *__link = __l->_M_next;
+        --_S_live_count;
+        --__l->_M_site->_M_live;
+        __l->_M_site->_M_live_bytes -= __l->_M_bytes;
+        free(__l);
+        return;
+      }
+      __link = &__l->_M_next;
+    }
+}
+
+template <int __inst>
+typename __alloc_sampler<__inst>::_Site*
+__alloc_sampler<__inst>::_S_find_site(void** __stack, int __depth)
+{
+    size_t __hash = 0;
+    int __i;
+    for (__i = 0; __i < __depth; ++__i)
+      __hash = (__hash + (size_t) __stack[__i]) * 0x9e3779b1u;
+    _Site** __bucket =
+      _S_sites + ((__hash ^ (__hash >> 16)) & (_S_SITE_BUCKETS - 1));
+    _Site* __site;
+    for (__site = *__bucket; 0 != __site; __site = __site->_M_next)
+      if (__site->_M_hash == __hash && __site->_M_depth == __depth &&
+          0 == memcmp(__site->_M_stack, __stack, __depth * sizeof(void*)))
+        return __site;
+    __site = (_Site*) malloc(sizeof(_Site));
+    if (0 == __site) return 0;
+    memset((void*) __site, 0, sizeof(_Site));
+    __site->_M_hash = __hash;
+    __site->_M_depth = __depth;
+    memcpy(__site->_M_stack, __stack, __depth * sizeof(void*));
+    __site->_M_next = *__bucket;
+    *__bucket = __site;
+    return __site;
+}
+
+template <int __inst>
+void __alloc_sampler<__inst>::write_heap_profile(FILE* __f)
+{
+    {
+# ifdef __STL_THREADS
+      /*REFERENCED*/
+      _STL_auto_lock __lock_instance(_S_lock);
+# endif
+      size_t __allocs = 0, __alloc_bytes = 0, __live = 0, __live_bytes = 0;
+      size_t __b;
+      _Site* __site;
+      for (__b = 0; __b < (size_t) _S_SITE_BUCKETS; ++__b)
+        for (__site = _S_sites[__b]; 0 != __site; __site = __site->_M_next) {
+          __allocs += __site->_M_allocs;
+          __alloc_bytes += __site->_M_alloc_bytes;
+          __live += __site->_M_live;
+          __live_bytes += __site->_M_live_bytes;
+        }
+      fprintf(__f, "heap profile: %6lu: %8lu [%6lu: %8lu] @ heap_v2/%lu\n",
+              (unsigned long) __live, (unsigned long) __live_bytes,
+              (unsigned long) __allocs, (unsigned long) __alloc_bytes,
+              (unsigned long) _S_period);
+      for (__b = 0; __b < (size_t) _S_SITE_BUCKETS; ++__b)
+        for (__site = _S_sites[__b]; 0 != __site; __site = __site->_M_next) {
+          fprintf(__f, "%6lu: %8lu [%6lu: %8lu] @",
+                  (unsigned long) __site->_M_live,
+                  (unsigned long) __site->_M_live_bytes,
+                  (unsigned long) __site->_M_allocs,
+                  (unsigned long) __site->_M_alloc_bytes);
+          for (int __i = 0; __i < __site->_M_depth; ++__i)
+            fprintf(__f, " 0x%lx", (unsigned long) __site->_M_stack[__i]);
+          fputc('\n', __f);
+        }
+    }
+    // pprof maps the addresses back to functions with the address space
+    // layout.
+    fputs("\nMAPPED_LIBRARIES:\n", __f);
+    FILE* __maps = fopen("/proc/self/maps", "r");
+    if (0 != __maps) {
+      char __buf[4096];
+      size_t __k;
+      while (0 != (__k = fread(__buf, 1, sizeof(__buf), __maps)))
+        fwrite(__buf, 1, __k, __f);
+      fclose(__maps);
+    }
+}
+
+template <int __inst>
+bool __alloc_sampler<__inst>::dump_heap_profile(const char* __path)
+{
+    FILE* __f = fopen(__path, "w");
+    if (0 == __f) return false;
+    write_heap_profile(__f);
+    bool __ok = !ferror(__f);
+    return 0 == fclose(__f) && __ok;
+}
+
+#endif /* __STL_ALLOC_SAMPLING */
+
+#ifdef __STL_ALLOC_TRACING
+
+// Allocation tracing, for tuning the node allocator's size classes and
+// chunk sizes against a real workload.  While a trace is recorded,
+// every request that reaches __default_alloc_template (and so every
+// shard of the sharded allocator) appends a _Record to a buffer of the
+// calling thread: the size asked for, allocation or deallocation, a
+// small number naming the thread, and a sequence number taken from a
+// counter all threads share.  A full buffer is written out under a
+// lock, so the lock is taken once per _S_BUFFER_RECORDS events.
+//   alloc_tracer::start("/tmp/app.trace");
+//   ...
+//   alloc_tracer::stop();
+// The file holds the eight bytes "STLTRACE", the version and the size
+// of a record as two unsigned ints, and then the records, all in the
+// byte order of the machine that wrote them.  Each thread's records
+// appear in the order it made them, but the blocks of different
+// threads interleave as they filled up; the sequence numbers put the
+// events back in the order they happened.  They wrap around, so
+// compare them as serial numbers.  Blocks are not named: an object
+// goes back to the class its size picks.  A reallocation in place, and
+// a try_expand that succeeds, are recorded as a deallocation of the
+// old size and an allocation of the new one.
+// alloc_replay, under SGI-STL Test/allocator_test, replays a trace
+// against other size classes and chunk sizes.
+// stop() writes out what the buffers of all threads hold; events that
+// threads still allocating record meanwhile may be lost.  Under
+// threads this relies on gcc's __sync builtins; without them the
+// sequence numbers take the lock, and stop() may write out a record
+// another thread has not finished.  While no trace is recorded, a
+// request costs one load.
+// 分配轨迹: 每次请求记一条 (大小, 分配/释放, 线程, 全局序号), 按线程缓冲,
+// 满了才加锁写文件; 回放时按序号归并各线程的记录.
+
+template <int __inst>
+class __alloc_tracer {
+public:
+  enum {_S_ALLOCATE = 0, _S_DEALLOCATE = 1};
+  enum {_S_VERSION = 2};
+  struct _Record {
+    unsigned int _M_size;               // Clamped to 2^32 - 1.
+    unsigned int _M_thread_op;          // thread << 1 | op
+    unsigned int _M_seq;                // Order among all threads.
+  };
+
+private:
+  enum {_S_BUFFER_RECORDS = 1024};
+  struct _Thread_buffer {
+    _Thread_buffer* _M_next;            // Every buffer made so far,
+    _Thread_buffer* _M_next_free;       // and those of exited threads.
+    unsigned int _M_thread;
+    // Only the owning thread changes _M_count, so that stop() can
+    // write out the records below it from another thread.
+    size_t __STL_VOLATILE _M_count;
+    size_t _M_written;                  // Records already in the file.
+    _Record _M_records[_S_BUFFER_RECORDS];
+  };
+
+  // Read without the lock, to let requests skip everything else.
+  static FILE* __STL_VOLATILE _S_file;
+  static bool _S_failed;                // A write went wrong.
+  static _Thread_buffer* _S_buffers;
+  static _Thread_buffer* _S_free_buffers;
+  static unsigned int _S_next_thread;
+# ifdef __STL_THREADS
+  static _STL_mutex_lock _S_lock;       // Guards all of the above.
+# endif
+  static unsigned int __STL_VOLATILE _S_next_seq;
+
+  // The owner counts a record only once it is complete, and stop()
+  // reads the count before the records; under gcc the atomic builtins
+  // order the two.
+  static size_t _S_publish(_Thread_buffer* __b) {
+# if defined(__STL_THREADS) && defined(__GNUC__)
+    return __sync_add_and_fetch(&__b->_M_count, (size_t) 1);
+# else
+    return ++__b->_M_count;
+# endif
+  }
+  static size_t _S_published(_Thread_buffer* __b) {
+# if defined(__STL_THREADS) && defined(__GNUC__)
+    return __sync_fetch_and_add(&__b->_M_count, (size_t) 0);
+# else
+    return __b->_M_count;
+# endif
+  }
+
+  static unsigned int _S_take_seq() {
+# if defined(__STL_THREADS) && defined(__GNUC__)
+    return __sync_fetch_and_add(&_S_next_seq, 1u);
+# elif defined(__STL_THREADS)
+    /*REFERENCED*/
+    _STL_auto_lock __lock_instance(_S_lock);
+    return _S_next_seq++;
+# else
+    return _S_next_seq++;
+# endif
+  }
+# ifdef __STL_PTHREADS
+  static pthread_key_t _S_buffer_key;
+  static bool _S_buffer_key_initialized;
+# else
+  static _Thread_buffer* _S_buffer;
+# endif
+
+  // Returns the calling thread's buffer, or 0 if it cannot be had; the
+  // request then simply goes unrecorded.
+  static _Thread_buffer* _S_get_buffer() {
+# ifdef __STL_PTHREADS
+    _Thread_buffer* __b;
+    if (!_S_buffer_key_initialized ||
+        0 == (__b = (_Thread_buffer*) pthread_getspecific(_S_buffer_key)))
+      __b = _S_new_buffer();
+    return __b;
+# else
+    if (0 == _S_buffer) _S_buffer = _S_new_buffer();
+    return _S_buffer;
+# endif
+  }
+  static _Thread_buffer* _S_new_buffer();
+# ifdef __STL_PTHREADS
+  // Called on thread exit; writes the buffer out and keeps it for the
+  // next thread.
+  static void _S_buffer_destructor(void* __b);
+# endif
+  // Writes out the records of __b not yet written, if a trace is open.
+  // Called with the lock held.
+  static void _S_write(_Thread_buffer* __b);
+  // Writes __b out and empties it.  Called by the thread owning __b.
+  static void _S_flush(_Thread_buffer* __b);
+
+public:
+  // Starts recording to the file __path, finishing any trace already
+  // being recorded.  Returns false if the file could not be opened.
+  static bool start(const char* __path);
+  // Writes out every buffer and closes the trace.  Returns false if no
+  // trace was open or it could not be written completely.
+  static bool stop();
+  static bool recording() { return 0 != _S_file; }
+
+  // Called by the node allocator with every request.
+  static void _S_note(size_t __n, int __op) {
+    if (0 == _S_file) return;
+    _Thread_buffer* __b = _S_get_buffer();
+    if (0 == __b) return;
+    _Record* __r = __b->_M_records + _S_published(__b);
+    __r->_M_size = __n > (size_t) 0xffffffffu ? 0xffffffffu
+                                              : (unsigned int) __n;
+    __r->_M_thread_op = __b->_M_thread << 1 | (unsigned int) __op;
+    __r->_M_seq = _S_take_seq();
+    if (_S_publish(__b) >= (size_t) _S_BUFFER_RECORDS)
+      _S_flush(__b);
+  }
+  // A block of __old_sz bytes now holds __new_sz in place.
+  static void _S_note_resize(size_t __old_sz, size_t __new_sz) {
+    _S_note(__old_sz, _S_DEALLOCATE);
+    _S_note(__new_sz, _S_ALLOCATE);
+  }
+};
+
+typedef __alloc_tracer<0> alloc_tracer;
+
+template <int __inst>
+FILE* __STL_VOLATILE __alloc_tracer<__inst>::_S_file = 0;
+template <int __inst>
+bool __alloc_tracer<__inst>::_S_failed = false;
+template <int __inst>
+typename __alloc_tracer<__inst>::_Thread_buffer*
+__alloc_tracer<__inst>::_S_buffers = 0;
+template <int __inst>
+typename __alloc_tracer<__inst>::_Thread_buffer*
+__alloc_tracer<__inst>::_S_free_buffers = 0;
+template <int __inst>
+unsigned int __alloc_tracer<__inst>::_S_next_thread = 0;
+template <int __inst>
+unsigned int __STL_VOLATILE __alloc_tracer<__inst>::_S_next_seq = 0;
+# ifdef __STL_THREADS
+template <int __inst>
+_STL_mutex_lock __alloc_tracer<__inst>::_S_lock __STL_MUTEX_INITIALIZER;
+# endif
+# ifdef __STL_PTHREADS
+template <int __inst>
+pthread_key_t __alloc_tracer<__inst>::_S_buffer_key;
+template <int __inst>
+bool __alloc_tracer<__inst>::_S_buffer_key_initialized = false;
+# else
+template <int __inst>
+typename __alloc_tracer<__inst>::_Thread_buffer*
+__alloc_tracer<__inst>::_S_buffer = 0;
+# endif
+
+template <int __inst>
+typename __alloc_tracer<__inst>::_Thread_buffer*
+__alloc_tracer<__inst>::_S_new_buffer()
+{
+    _Thread_buffer* __b;
+    {
+# ifdef __STL_THREADS
+        /*REFERENCED*/
+        _STL_auto_lock __lock_instance(_S_lock);
+# endif
+# ifdef __STL_PTHREADS
+        if (!_S_buffer_key_initialized) {
+            if (pthread_key_create(&_S_buffer_key, _S_buffer_destructor))
+                return 0;
+            _S_buffer_key_initialized = true;
+        }
+# endif
+        if (0 != _S_free_buffers) {
+            __b = _S_free_buffers;
+            _S_free_buffers = __b->_M_next_free;
+        } else {
+            __b = (_Thread_buffer*) malloc(sizeof(_Thread_buffer));
+            if (0 == __b) return 0;
+            __b->_M_next = _S_buffers;
+            _S_buffers = __b;
+        }
+        // A fresh number even for a reused buffer: it is a new thread.
+        __b->_M_thread = _S_next_thread++ & 0x7fffffffu;
+        __b->_M_count = 0;
+        __b->_M_written = 0;
+    }
+# ifdef __STL_PTHREADS
+    if (pthread_setspecific(_S_buffer_key, __b)) {
+        /*REFERENCED*/
+        _STL_auto_lock __lock_instance(_S_lock);
+        __b->_M_next_free = _S_free_buffers;
+        _S_free_buffers = __b;
+        return 0;
+    }
+# endif
+    return __b;
+}
+
+# ifdef __STL_PTHREADS
+template <int __inst>
+void __alloc_tracer<__inst>::_S_buffer_destructor(void* __p)
+{
+    _Thread_buffer* __b = (_Thread_buffer*) __p;
+    /*REFERENCED*/
+    _STL_auto_lock __lock_instance(_S_lock);
+    _S_write(__b);
+    __b->_M_next_free = _S_free_buffers;
+    _S_free_buffers = __b;
+}
+# endif
+
+template <int __inst>
+void __alloc_tracer<__inst>::_S_write(_Thread_buffer* __b)
+{
+    size_t __count = _S_published(__b);
+    if (__count <= __b->_M_written) return;
+    size_t __n = __count - __b->_M_written;
+    if (0 != _S_file &&
+        fwrite(__b->_M_records + __b->_M_written, sizeof(_Record), __n,
+               _S_file) != __n)
+        _S_failed = true;
+    __b->_M_written = __count;
+}
+
+template <int __inst>
+void __alloc_tracer<__inst>::_S_flush(_Thread_buffer* __b)
+{
+# ifdef __STL_THREADS
+    /*REFERENCED*/
+    _STL_auto_lock __lock_instance(_S_lock);
+# endif
+    _S_write(__b);
+    __b->_M_count = 0;
+    __b->_M_written = 0;
+}
+
+template <int __inst>
+bool __alloc_tracer<__inst>::start(const char* __path)
+{
+    stop();
+    FILE* __f = fopen(__path, "wb");
+    if (0 == __f) return false;
+    unsigned int __header[2];
+    __header[0] = (unsigned int) _S_VERSION;
+    __header[1] = (unsigned int) sizeof(_Record);
+    if (fwrite("STLTRACE", 1, 8, __f) != 8 ||
+        fwrite(__header, sizeof(__header), 1, __f) != 1) {
+        fclose(__f);
+        return false;
+    }
+# ifdef __STL_THREADS
+    /*REFERENCED*/
+    _STL_auto_lock __lock_instance(_S_lock);
+# endif
+    // Drop whatever was recorded while the last trace was being closed.
+    for (_Thread_buffer* __b = _S_buffers; 0 != __b; __b = __b->_M_next)
+        __b->_M_written = _S_published(__b);
+    _S_failed = false;
+    _S_file = __f;
+    return true;
+}
+
+template <int __inst>
+bool __alloc_tracer<__inst>::stop()
+{
+# ifdef __STL_THREADS
+    /*REFERENCED*/
+    _STL_auto_lock __lock_instance(_S_lock);
+# endif
+    FILE* __f = _S_file;
+    if (0 == __f) return false;
+    for (_Thread_buffer* __b = _S_buffers; 0 != __b; __b = __b->_M_next)
+        _S_write(__b);
+    _S_file = 0;
+    bool __ok = !_S_failed && !ferror(__f);
+    return 0 == fclose(__f) && __ok;
+}
+
+#endif /* __STL_ALLOC_TRACING */
+
 /*
   为alloc的封装，包装接口使其符合STL的规范
   后续的容器全部使用这个接口 
@@ -200,36 +1540,183 @@ template<class _Tp, class _Alloc>
 class simple_alloc {
 
 public:
-    static _Tp* allocate(size_t __n)
-      { return 0 == __n ? 0 : (_Tp*) _Alloc::allocate(__n * sizeof (_Tp)); }
-    static _Tp* allocate(void)
-      { return (_Tp*) _Alloc::allocate(sizeof (_Tp)); }
-    static void deallocate(_Tp* __p, size_t __n)
-      { if (0 != __n) _Alloc::deallocate(__p, __n * sizeof (_Tp)); }
-    static void deallocate(_Tp* __p)
-      { _Alloc::deallocate(__p, sizeof (_Tp)); }
+    static _Tp* allocate(size_t __n) {
+      _Tp* __result =
+        0 == __n ? 0 : (_Tp*) _Alloc::allocate(__n * sizeof (_Tp));
+      __STL_ALLOC_SAMPLE(
+        alloc_sampler::_S_note_allocate(__result, __n * sizeof (_Tp)));
+      return __result;
+    }
+    static _Tp* allocate(void) {
+      _Tp* __result = (_Tp*) _Alloc::allocate(sizeof (_Tp));
+      __STL_ALLOC_SAMPLE(
+        alloc_sampler::_S_note_allocate(__result, sizeof (_Tp)));
+      return __result;
+    }
+    static void deallocate(_Tp* __p, size_t __n) {
+      if (0 != __n) {
+        __STL_ALLOC_SAMPLE(alloc_sampler::_S_note_deallocate(__p));
+        _Alloc::deallocate(__p, __n * sizeof (_Tp));
+      }
+    }
+    static void deallocate(_Tp* __p) {
+      __STL_ALLOC_SAMPLE(alloc_sampler::_S_note_deallocate(__p));
+      _Alloc::deallocate(__p, sizeof (_Tp));
+    }
+
+    // The extended protocol, counted in objects rather than bytes.
+    static _Tp* allocate_at_least(size_t __n, size_t& __got) {
+      if (0 == __n) { __got = 0; return 0; }
+      size_t __bytes;
+      _Tp* __result = (_Tp*)
+        _Alloc_extensions<_Alloc>::allocate_at_least(__n * sizeof (_Tp),
+                                                     __bytes);
+      __STL_ALLOC_SAMPLE(alloc_sampler::_S_note_allocate(__result, __bytes));
+      __got = __bytes / sizeof (_Tp);
+      return __result;
+    }
+    static bool try_expand(_Tp* __p, size_t __old_n, size_t __new_n) {
+      return 0 != __p &&
+        _Alloc_extensions<_Alloc>::try_expand(__p, __old_n * sizeof (_Tp),
+                                              __new_n * sizeof (_Tp));
+    }
+    static _Tp* allocate_aligned(size_t __n, size_t __align) {
+      _Tp* __result = 0 == __n ? 0 : (_Tp*)
+        _Alloc_extensions<_Alloc>::allocate_aligned(__n * sizeof (_Tp),
+                                                    __align);
+      __STL_ALLOC_SAMPLE(
+        alloc_sampler::_S_note_allocate(__result, __n * sizeof (_Tp)));
+      return __result;
+    }
+    // Fills __out with __n objects, each to be deallocated on its own.
+    static void allocate_n_nodes(size_t __n, _Tp** __out) {
+      _Alloc_extensions<_Alloc>::allocate_n_nodes(sizeof (_Tp), __n,
+                                                  (void**) __out);
+      __STL_ALLOC_SAMPLE(for (size_t __i = 0; __i < __n; ++__i)
+        alloc_sampler::_S_note_allocate(__out[__i], sizeof (_Tp)));
+    }
+    static void deallocate_aligned(_Tp* __p, size_t __n, size_t __align) {
+      if (0 != __n) {
+        __STL_ALLOC_SAMPLE(alloc_sampler::_S_note_deallocate(__p));
+        _Alloc_extensions<_Alloc>::deallocate_aligned(__p,
+                                                      __n * sizeof (_Tp),
+                                                      __align);
+      }
+    }
 };
 
+// Range inserts ask for their nodes this many at a time.
+enum { __stl_node_batch = 32 };
+
 // Allocator adaptor to check size arguments for debugging.
 // Reports errors using assert.  Checking can be disabled with
 // NDEBUG, but it's far better to just use the underlying allocator
 // instead when no checking is desired.
 // There is some evidence that this can confuse Purify.
+//
+// With __STL_DEBUG_ALLOC_CHECKS it checks a good deal more, and
+// reports errors on stderr and aborts whether or not NDEBUG is set.
+// A block is then laid out as
+//   header | front redzone | the client's __n bytes | rear redzone
+// where the header holds __n and whether the block is live, and the
+// rear redzone also takes the padding up to a multiple of 8.  Fresh
+// memory is filled with _S_CLEAN_BYTE and freed memory with
+// _S_DEAD_BYTE.  Freed blocks wait in a quarantine of
+// __STL_DEBUG_ALLOC_QUARANTINE bytes before going back to _Alloc, so
+// that a second free, or a write through a dangling pointer, is seen
+// while the block is still ours.  Blocks still live at exit are
+// reported, grouped by size; those owned by static containers count.
+// With __STL_DEBUG_ALLOC_GUARD_PAGES each block is mapped on pages of
+// its own, with its end against an inaccessible page, and its pages
+// are made inaccessible when it is freed; overruns and uses after free
+// then fault at once, but so does a second free.
+// 调试模式: 红区检查越界, 释放后填充+隔离区检查重复释放, 退出时按大小报告泄漏
 template <class _Alloc>
 class debug_alloc {
 
 private:
 
+# ifndef __STL_DEBUG_ALLOC_CHECKS
   enum {_S_extra = 8};  // Size of space used to store size.  Note
                         // that this must be large enough to preserve
                         // alignment.
+# else /* __STL_DEBUG_ALLOC_CHECKS */
+  struct _Header {
+    size_t _M_size;
+    size_t _M_state;    // _S_LIVE or _S_FREED
+  };
+  enum {_S_REDZONE = __STL_DEBUG_ALLOC_REDZONE};
+  enum {_S_FRONT = sizeof(_Header) + _S_REDZONE};
+#   ifdef __STL_DEBUG_ALLOC_GUARD_PAGES
+  enum {_S_REAR = 0};   // The guard page takes the rear redzone's place.
+#   else
+  enum {_S_REAR = _S_REDZONE};
+#   endif
+  enum {_S_LIVE = 0x4c495645, _S_FREED = 0x44454144};
+  enum {_S_REDZONE_BYTE = 0xfb, _S_CLEAN_BYTE = 0xcd, _S_DEAD_BYTE = 0xdd};
+  // 16 classes 8 bytes apart up to 128, then one per power of 2.
+  enum {_S_NCLASSES = 16 + 8 * sizeof(size_t) - 7};
+  enum {_S_QUARANTINE_SLOTS = 4096};
+
+  struct _Quarantined {
+    char* _M_real_p;
+    size_t _M_size;
+  };
+
+  static size_t _S_live_count[_S_NCLASSES];
+  static size_t _S_live_bytes[_S_NCLASSES];
+  static _Quarantined _S_quarantine[_S_QUARANTINE_SLOTS];
+  static size_t _S_quarantine_head;     // The oldest entry.
+  static size_t _S_quarantine_count;
+  static size_t _S_quarantine_bytes;
+  static bool _S_report_registered;
+#   ifdef __STL_THREADS
+  static _STL_mutex_lock _S_lock;       // Guards all of the above.
+#   endif
+
+  // Bytes taken from _Alloc for a client block of __n bytes.
+  static size_t _S_real_size(size_t __n)
+    { return (size_t) _S_FRONT + ((__n + 7) & ~(size_t) 7) + _S_REAR; }
+
+  static size_t _S_class(size_t __n) {
+    if (__n <= 128) return 0 == __n ? 0 : (__n - 1) >> 3;
+    size_t __i = 16;
+    for (size_t __m = (__n - 1) >> 8; __m != 0; __m >>= 1) ++__i;
+    return __i;
+  }
+
+  static char* _S_get_block(size_t __n);
+  static void _S_put_block(char* __real_p, size_t __n);
+  static void _S_quarantine_block(char* __real_p, size_t __n);
+  static void _S_check_block(char* __real_p, size_t __n);
+  static void _S_fail(const char* __what, const void* __p, size_t __n);
+  static void _S_register_report();
+  static void _S_report_leaks();
+# endif /* __STL_DEBUG_ALLOC_CHECKS */
 
 public:
+# ifdef __STL_ALLOC_STATS
+  // Sizes are the client's; each object also costs _S_extra bytes.
+  struct stats_type {
+    size_t _M_allocs;
+    size_t _M_frees;
+    size_t _M_bytes_allocated;
+    size_t _M_bytes_freed;
+  };
+  static void get_stats(stats_type& __s) { __s = _S_stats; }
+private:
+  static stats_type _S_stats;
+public:
+# endif /* __STL_ALLOC_STATS */
+
+# ifndef __STL_DEBUG_ALLOC_CHECKS
 
   static void* allocate(size_t __n)
   {
     char* __result = (char*)_Alloc::allocate(__n + (int) _S_extra);
     *(size_t*)__result = __n;
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_allocs, 1));
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_bytes_allocated, __n));
     return __result + (int) _S_extra;
   }
 
@@ -239,6 +1726,8 @@ public:
     char* __real_p = (char*)__p - (int) _S_extra;
     assert(*(size_t*)__real_p == __n);
     _Alloc::deallocate(__real_p, __n + (int) _S_extra);
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_frees, 1));
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_bytes_freed, __n));
   }
 
   static void* reallocate(void* __p, size_t __old_sz, size_t __new_sz)
@@ -249,16 +1738,230 @@ public:
       _Alloc::reallocate(__real_p, __old_sz + (int) _S_extra,
                                    __new_sz + (int) _S_extra);
     *(size_t*)__result = __new_sz;
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_bytes_allocated, __new_sz));
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_bytes_freed, __old_sz));
     return __result + (int) _S_extra;
   }
 
+# else /* __STL_DEBUG_ALLOC_CHECKS */
+
+  static void* allocate(size_t __n)
+  {
+    if (!_S_report_registered) _S_register_report();
+    char* __real_p = _S_get_block(__n);
+    char* __result = __real_p + (int) _S_FRONT;
+    ((_Header*) __real_p)->_M_size = __n;
+    ((_Header*) __real_p)->_M_state = (size_t) _S_LIVE;
+    memset(__real_p + sizeof(_Header), _S_REDZONE_BYTE, (int) _S_REDZONE);
+    memset(__result, _S_CLEAN_BYTE, __n);
+    memset(__result + __n, _S_REDZONE_BYTE,
+           _S_real_size(__n) - (size_t) _S_FRONT - __n);
+    __stl_stat_add(&_S_live_count[_S_class(__n)], 1);
+    __stl_stat_add(&_S_live_bytes[_S_class(__n)], __n);
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_allocs, 1));
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_bytes_allocated, __n));
+    return __result;
+  }
+
+  static void deallocate(void* __p, size_t __n)
+  {
+    char* __real_p = (char*)__p - (int) _S_FRONT;
+    _S_check_block(__real_p, __n);
+    ((_Header*) __real_p)->_M_state = (size_t) _S_FREED;
+    memset(__p, _S_DEAD_BYTE, __n);
+    __stl_stat_add(&_S_live_count[_S_class(__n)], (size_t) -1);
+    __stl_stat_add(&_S_live_bytes[_S_class(__n)], (size_t) 0 - __n);
+    _S_quarantine_block(__real_p, __n);
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_frees, 1));
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_bytes_freed, __n));
+  }
+
+  // Always moves the block, so that stale pointers to it are caught.
+  static void* reallocate(void* __p, size_t __old_sz, size_t __new_sz)
+  {
+    void* __result = allocate(__new_sz);
+    memcpy(__result, __p, __old_sz < __new_sz ? __old_sz : __new_sz);
+    deallocate(__p, __old_sz);
+    return __result;
+  }
+
+# endif /* __STL_DEBUG_ALLOC_CHECKS */
+
 };
 
+#ifdef __STL_ALLOC_STATS
+template <class _Alloc>
+typename debug_alloc<_Alloc>::stats_type debug_alloc<_Alloc>::_S_stats;
+#endif
+
+#ifdef __STL_DEBUG_ALLOC_CHECKS
+
+template <class _Alloc>
+size_t debug_alloc<_Alloc>::_S_live_count[debug_alloc<_Alloc>::_S_NCLASSES];
+template <class _Alloc>
+size_t debug_alloc<_Alloc>::_S_live_bytes[debug_alloc<_Alloc>::_S_NCLASSES];
+template <class _Alloc>
+typename debug_alloc<_Alloc>::_Quarantined
+debug_alloc<_Alloc>::_S_quarantine[debug_alloc<_Alloc>::_S_QUARANTINE_SLOTS];
+template <class _Alloc>
+size_t debug_alloc<_Alloc>::_S_quarantine_head = 0;
+template <class _Alloc>
+size_t debug_alloc<_Alloc>::_S_quarantine_count = 0;
+template <class _Alloc>
+size_t debug_alloc<_Alloc>::_S_quarantine_bytes = 0;
+template <class _Alloc>
+bool debug_alloc<_Alloc>::_S_report_registered = false;
+# ifdef __STL_THREADS
+template <class _Alloc>
+_STL_mutex_lock debug_alloc<_Alloc>::_S_lock __STL_MUTEX_INITIALIZER;
+# endif
+
+template <class _Alloc>
+char* debug_alloc<_Alloc>::_S_get_block(size_t __n)
+{
+# ifdef __STL_DEBUG_ALLOC_GUARD_PAGES
+    // Map whole pages plus one, and end the block where the last,
+    // inaccessible page begins.
+    size_t __page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t __real_sz = _S_real_size(__n);
+    size_t __len = (__real_sz + __page - 1) & ~(__page - 1);
+    char* __map = (char*) mmap(0, __len + __page, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == (void*) __map) { __THROW_BAD_ALLOC; }
+    mprotect(__map + __len, __page, PROT_NONE);
+    return __map + __len - __real_sz;
+# else
+    return (char*) _Alloc::allocate(_S_real_size(__n));
+# endif
+}
+
+template <class _Alloc>
+void debug_alloc<_Alloc>::_S_put_block(char* __real_p, size_t __n)
+{
+# ifdef __STL_DEBUG_ALLOC_GUARD_PAGES
+    size_t __page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t __real_sz = _S_real_size(__n);
+    size_t __len = (__real_sz + __page - 1) & ~(__page - 1);
+    munmap(__real_p + __real_sz - __len, __len + __page);
+# else
+    _Alloc::deallocate(__real_p, _S_real_size(__n));
+# endif
+}
+
+// Checks a block that is about to be freed.
+template <class _Alloc>
+void debug_alloc<_Alloc>::_S_check_block(char* __real_p, size_t __n)
+{
+    _Header* __h = (_Header*) __real_p;
+    char* __p = __real_p + (int) _S_FRONT;
+    if ((size_t) _S_FREED == __h->_M_state)
+      _S_fail("double free", __p, __n);
+    if ((size_t) _S_LIVE != __h->_M_state)
+      _S_fail("free of a block it did not allocate, or underflow past "
+              "the redzone", __p, __n);
+    if (__h->_M_size != __n)
+      _S_fail("size passed to deallocate differs from allocate", __p, __n);
+    const char* __c = __real_p + sizeof(_Header);
+    for ( ; __c != __p; ++__c)
+      if ((char) _S_REDZONE_BYTE != *__c)
+        _S_fail("buffer underflow", __p, __n);
+    const char* __end = __real_p + _S_real_size(__n);
+    for (__c = __p + __n; __c != __end; ++__c)
+      if ((char) _S_REDZONE_BYTE != *__c)
+        _S_fail("buffer overflow", __p, __n);
+}
+
+template <class _Alloc>
+void debug_alloc<_Alloc>::_S_quarantine_block(char* __real_p, size_t __n)
+{
+# ifdef __STL_DEBUG_ALLOC_GUARD_PAGES
+    size_t __page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t __real_sz = _S_real_size(__n);
+    size_t __len = (__real_sz + __page - 1) & ~(__page - 1);
+    mprotect(__real_p + __real_sz - __len, __len, PROT_NONE);
+# endif
+# ifdef __STL_THREADS
+    _STL_auto_lock __lock_instance(_S_lock);
+# endif
+    size_t __tail =
+      (_S_quarantine_head + _S_quarantine_count) % _S_QUARANTINE_SLOTS;
+    _S_quarantine[__tail]._M_real_p = __real_p;
+    _S_quarantine[__tail]._M_size = __n;
+    ++_S_quarantine_count;
+    _S_quarantine_bytes += __n;
+    while (_S_quarantine_count == (size_t) _S_QUARANTINE_SLOTS ||
+           _S_quarantine_bytes > (size_t) __STL_DEBUG_ALLOC_QUARANTINE) {
+      _Quarantined& __q = _S_quarantine[_S_quarantine_head];
+#   ifndef __STL_DEBUG_ALLOC_GUARD_PAGES
+      const char* __p = __q._M_real_p + (int) _S_FRONT;
+      for (size_t __i = 0; __i < __q._M_size; ++__i)
+        if ((char) _S_DEAD_BYTE != __p[__i])
+          _S_fail("write after free", __p, __q._M_size);
+#   endif
+      _S_put_block(__q._M_real_p, __q._M_size);
+      _S_quarantine_head = (_S_quarantine_head + 1) % _S_QUARANTINE_SLOTS;
+      --_S_quarantine_count;
+      _S_quarantine_bytes -= __q._M_size;
+    }
+}
+
+template <class _Alloc>
+void debug_alloc<_Alloc>::_S_fail(const char* __what, const void* __p,
+                                  size_t __n)
+{
+    fprintf(stderr, "debug_alloc: %s: block %p of %lu bytes\n",
+            __what, __p, (unsigned long) __n);
+    abort();
+}
+
+template <class _Alloc>
+void debug_alloc<_Alloc>::_S_register_report()
+{
+# ifdef __STL_THREADS
+    _STL_auto_lock __lock_instance(_S_lock);
+# endif
+    if (!_S_report_registered) {
+      atexit(_S_report_leaks);
+      _S_report_registered = true;
+    }
+}
+
+template <class _Alloc>
+void debug_alloc<_Alloc>::_S_report_leaks()
+{
+    size_t __count = 0;
+    size_t __bytes = 0;
+    size_t __i;
+    for (__i = 0; __i < (size_t) _S_NCLASSES; ++__i) {
+      __count += _S_live_count[__i];
+      __bytes += _S_live_bytes[__i];
+    }
+    if (0 == __count) return;
+    fprintf(stderr, "debug_alloc: %lu blocks (%lu bytes) not freed at exit\n",
+            (unsigned long) __count, (unsigned long) __bytes);
+    for (__i = 0; __i < (size_t) _S_NCLASSES; ++__i) {
+      if (0 == _S_live_count[__i]) continue;
+      size_t __limit = __i < 16 ? (__i + 1) * 8
+                     : __i + 1 < (size_t) _S_NCLASSES
+                       ? (size_t) 1 << (__i - 8) : (size_t) -1;
+      fprintf(stderr, "  size <= %10lu: %8lu blocks %12lu bytes\n",
+              (unsigned long) __limit, (unsigned long) _S_live_count[__i],
+              (unsigned long) _S_live_bytes[__i]);
+    }
+}
+
+#endif /* __STL_DEBUG_ALLOC_CHECKS */
+
 
 # ifdef __USE_MALLOC
 
+#ifdef __STL_USE_DEBUG_ALLOC
+typedef debug_alloc<malloc_alloc> alloc;
+typedef debug_alloc<malloc_alloc> single_client_alloc;
+#else
 typedef malloc_alloc alloc;
 typedef malloc_alloc single_client_alloc;
+#endif
 
 # else
 
@@ -278,37 +1981,160 @@ typedef malloc_alloc single_client_alloc;
 //    without permanently losing part of the object.
 //
 
-// The first template parameter specifies whether more than one thread
-// may use this allocator.  It is safe to allocate an object from
-// one instance of a default_alloc and deallocate it with another
-// one.  This effectively transfers its ownership to the second one.
-// This may have undesirable effects on reference locality.
-// The second parameter is unreferenced and serves only to allow the
-// creation of multiple default_alloc instances.
-// Node that containers built on different allocator instances have
-// different types, limiting the utility of this approach.
+// The first template parameter specifies whether more than one thread
+// may use this allocator.  It is safe to allocate an object from
+// one instance of a default_alloc and deallocate it with another
+// one.  This effectively transfers its ownership to the second one.
+// This may have undesirable effects on reference locality.
+// The second parameter is unreferenced and serves only to allow the
+// creation of multiple default_alloc instances.
+// Node that containers built on different allocator instances have
+// different types, limiting the utility of this approach.
+
+// Size classes.  A size class policy tells the default allocator how
+// requests up to _MAX_BYTES are grouped onto its free lists.  It has
+// three enumerators, _ALIGN, _MAX_BYTES and _NFREELISTS, and three
+// static member functions:
+//    static size_t _S_freelist_index(size_t __bytes)  // 0 < __bytes <= _MAX_BYTES
+//    static size_t _S_round_up(size_t __bytes)        // size of that class
+//    static size_t _S_class_size(size_t __index)
+// Every class size is a multiple of _ALIGN.
+
+// floor(log2(__n)), __n > 0.
+inline size_t __stl_lg_floor(size_t __n)
+{
+# ifdef __GNUC__
+    return (sizeof(unsigned long) * 8 - 1) ^ __builtin_clzl(__n);
+# else
+    size_t __k;
+    for (__k = 0; __n > 1; __n >>= 1) ++__k;
+    return __k;
+# endif
+}
+
+// log2 of a power of 2, at compile time.
+template <size_t __n>
+struct _Stl_static_lg {
+  enum {_M_value = 1 + _Stl_static_lg<__n / 2>::_M_value};
+};
+__STL_TEMPLATE_NULL struct _Stl_static_lg<1> {
+  enum {_M_value = 0};
+};
+
+// Classes evenly spaced _Align bytes apart.  This is the original SGI
+// layout: _Linear_size_classes<8, 128> gives 16 lists of 8, 16, ... 128.
+template <size_t _Align, size_t _MaxBytes>
+struct _Linear_size_classes {
+  enum {_ALIGN = _Align};
+  enum {_MAX_BYTES = _MaxBytes};
+  enum {_NFREELISTS = _MaxBytes / _Align};
+
+  static size_t _S_round_up(size_t __bytes)
+    { return (((__bytes) + (size_t) _ALIGN-1) & ~((size_t) _ALIGN - 1)); }
+  static size_t _S_freelist_index(size_t __bytes)
+    { return (((__bytes) + (size_t)_ALIGN-1)/(size_t)_ALIGN - 1); }
+  static size_t _S_class_size(size_t __index)
+    { return (__index + 1) * (size_t) _ALIGN; }
+};
+
+// Classes _Align bytes apart up to _LinearMax, then _Steps classes per
+// doubling up to _MaxBytes.  For example, <8, 128, 4096, 4> gives 8, 16,
+// ... 128, then 160, 192, 224, 256, 320, ... 4096.  All the arguments
+// must be powers of 2, and _LinearMax / _Steps must be at least _Align.
+// The index computation has no data-dependent branches: both halves are
+// computed and the result is picked with a mask.
+// 128字节之后按几何级数划分size class
+template <size_t _Align, size_t _LinearMax, size_t _MaxBytes, int _Steps>
+struct _Geometric_size_classes {
+  enum {_ALIGN = _Align};
+  enum {_MAX_BYTES = _MaxBytes};
+  enum {_S_LINEAR_LISTS = _LinearMax / _Align};
+  enum {_S_LG_LINEAR = _Stl_static_lg<_LinearMax>::_M_value};
+  enum {_S_LG_STEPS = _Stl_static_lg<_Steps>::_M_value};
+  enum {_NFREELISTS = _S_LINEAR_LISTS +
+          (_Stl_static_lg<_MaxBytes>::_M_value - _S_LG_LINEAR) * _Steps};
+
+  static size_t _S_freelist_index(size_t __bytes) {
+    size_t __linear = ((__bytes) + (size_t)_ALIGN-1)/(size_t)_ALIGN - 1;
+    size_t __lg = __stl_lg_floor((__bytes - 1) | (size_t) _LinearMax);
+    size_t __geometric = (size_t) _S_LINEAR_LISTS
+      + (__lg - (size_t) _S_LG_LINEAR) * (size_t) _Steps
+      + (((__bytes - 1) >> (__lg - (size_t) _S_LG_STEPS))
+         & ((size_t) _Steps - 1));
+    size_t __mask = (size_t) 0 - (size_t) (__bytes > (size_t) _LinearMax);
+    return __linear ^ ((__linear ^ __geometric) & __mask);
+  }
+  static size_t _S_class_size(size_t __index) {
+    size_t __linear = (__index + 1) * (size_t) _ALIGN;
+    size_t __mask =
+      (size_t) 0 - (size_t) (__index >= (size_t) _S_LINEAR_LISTS);
+    size_t __offset = (__index - (size_t) _S_LINEAR_LISTS) & __mask;
+    size_t __group = __offset >> _S_LG_STEPS;
+    size_t __step = __offset & (_Steps - 1);
+    size_t __geometric = ((size_t) _LinearMax << __group)
+      + ((__step + 1) << (_S_LG_LINEAR + __group - _S_LG_STEPS));
+    return __linear ^ ((__linear ^ __geometric) & __mask);
+  }
+  static size_t _S_round_up(size_t __bytes)
+    { return _S_class_size(_S_freelist_index(__bytes)); }
+};
+
+// The size classes of __default_alloc_template<threads, inst>.  The inst
+// argument exists only to tell allocator instances apart, so an instance
+// gets its own classes by specializing this template, e.g.
+//    template <> struct __node_alloc_size_policy<1>
+//      : public _Geometric_size_classes<8, 128, 4096, 4> {};
+//    typedef __default_alloc_template<true, 1> big_node_alloc;
+template <int __inst>
+struct __node_alloc_size_policy : public _Linear_size_classes<8, 128> {};
+
+// Where __default_alloc_template<threads, inst> gets its chunks.  Like
+// the size classes, this can be specialized for one instance, e.g.
+//    template <> struct __node_alloc_chunk_source<1>
+//      : public _Huge_page_chunk_source {};
+template <int __inst>
+struct __node_alloc_chunk_source : public __STL_DEFAULT_CHUNK_SOURCE {};
 
-#if defined(__SUNPRO_CC) || defined(__GNUC__)
-// breaks if we make these template class members:
-  enum {_ALIGN = 8};
-  enum {_MAX_BYTES = 128};
-  enum {_NFREELISTS = 16}; // _MAX_BYTES/_ALIGN
-#endif
+// The instance whose size classes and chunk source
+// __default_alloc_template<threads, inst> uses.  That is inst itself,
+// except for the shards of __sharded_alloc_template<threads, __i>,
+// which are numbered from __stl_shard_inst_base up and use those of __i.
+#ifdef __STL_NODE_ALLOCATOR_SHARDED
+enum {__stl_shard_inst_base = 0x10000};
+#endif /* __STL_NODE_ALLOCATOR_SHARDED */
+
+template <int __inst>
+struct __node_alloc_policy_inst {
+#ifdef __STL_NODE_ALLOCATOR_SHARDED
+  enum {_S_inst = __inst >= (int) __stl_shard_inst_base
+          ? (__inst - (int) __stl_shard_inst_base)
+              / __STL_NODE_ALLOCATOR_SHARDS
+          : __inst};
+#else /* __STL_NODE_ALLOCATOR_SHARDED */
+  enum {_S_inst = __inst};
+#endif /* __STL_NODE_ALLOCATOR_SHARDED */
+};
 
  /** 二级空间适配器**/
 template <bool threads, int inst>
 class __default_alloc_template {
 
 private:
+  typedef __node_alloc_size_policy<__node_alloc_policy_inst<inst>::_S_inst>
+          _Size_classes;
+  typedef __node_alloc_chunk_source<__node_alloc_policy_inst<inst>::_S_inst>
+          _Chunk_source;
   // Really we should use static const int x = N
   // instead of enum { x = N }, but few compilers accept the former.
-#if ! (defined(__SUNPRO_CC) || defined(__GNUC__))
-    enum {_ALIGN = 8};
-    enum {_MAX_BYTES = 128};
-    enum {_NFREELISTS = 16}; // _MAX_BYTES/_ALIGN
-# endif
+  enum {_ALIGN = _Size_classes::_ALIGN};
+  enum {_MAX_BYTES = _Size_classes::_MAX_BYTES};
+  enum {_NFREELISTS = _Size_classes::_NFREELISTS};
   static size_t
   _S_round_up(size_t __bytes) 
+    { return _Size_classes::_S_round_up(__bytes); }
+  // Rounds up to a multiple of _ALIGN, which need not be a class size.
+  static size_t
+  _S_align_up(size_t __bytes)
     { return (((__bytes) + (size_t) _ALIGN-1) & ~((size_t) _ALIGN - 1)); }
 
 __PRIVATE:
@@ -317,19 +2143,50 @@ __PRIVATE:
         char _M_client_data[1];    /* The client sees this.        */
   };
 private:
-# if defined(__SUNPRO_CC) || defined(__GNUC__) || defined(__HP_aCC)
+# ifdef __STL_NODE_ALLOCATOR_LOCK_FREE
+    // 无锁free list: 头指针和计数器一起CAS, 避免ABA
+    static _STL_lock_free_stack _S_free_list[];
+# elif defined(__SUNPRO_CC) || defined(__GNUC__) || defined(__HP_aCC)
     static _Obj* __STL_VOLATILE _S_free_list[]; 
         // Specifying a size results in duplicate def for 4.1
 # else
     static _Obj* __STL_VOLATILE _S_free_list[_NFREELISTS]; 
 # endif
   static  size_t _S_freelist_index(size_t __bytes) {
-        return (((__bytes) + (size_t)_ALIGN-1)/(size_t)_ALIGN - 1);
+        return _Size_classes::_S_freelist_index(__bytes);
+  }
+
+  // Free list primitives.  Unless the lists are lock-free, the caller
+  // holds the lock.  _S_pop_free answers 0 if the list is empty.
+  static _Obj* _S_pop_free(size_t __index) {
+# ifdef __STL_NODE_ALLOCATOR_LOCK_FREE
+    return (_Obj*) _S_free_list[__index]._M_pop();
+# else
+    _Obj* __result = _S_free_list[__index];
+    if (0 != __result)
+      _S_free_list[__index] = __result -> _M_free_list_link;
+    return __result;
+# endif
+  }
+  // Pushes the chain __first ... __last, already linked together.
+  static void _S_push_free(size_t __index, _Obj* __first, _Obj* __last) {
+# ifdef __STL_NODE_ALLOCATOR_LOCK_FREE
+    _S_free_list[__index]._M_push(__first, __last);
+# else
+    __last -> _M_free_list_link = _S_free_list[__index];
+    _S_free_list[__index] = __first;
+# endif
   }
 
   // Returns an object of size __n, and optionally adds to size __n free list.
   // 重新填充链表空间 空间从内存池中取得
-  static void* _S_refill(size_t __n);
+  static void* _S_refill(size_t __n)
+    { void* __result = 0; _S_refill_n(__n, 1, &__result); return __result; }
+  // Stores up to __want objects of size __n in __out, and answers how
+  // many; puts whatever else the pool gave on the free list.
+  static int _S_refill_n(size_t __n, int __want, void** __out);
+  // The most objects allocate_n_nodes asks one refill for.
+  enum {_S_REFILL_MAX = 128};
   // Allocates a chunk for nobjs of size size.  nobjs may be reduced
   // if it is inconvenient to allocate the requested number.
   // 构造内存池
@@ -340,6 +2197,51 @@ private:
   static char* _S_end_free;
   static size_t _S_heap_size; // 附加量
 
+# ifdef __STL_NODE_ALLOCATOR_TRIM
+  // Every chunk is _S_CHUNK_BYTES long and aligned on that boundary, so
+  // an object finds the header of its chunk by masking its address.
+  // _M_live counts the objects of the chunk that are neither on a free
+  // list nor in the unused part of the pool.  Chunks with no live
+  // objects can be given back by release_unused.
+  // chunk头部记录有多少区块在客户端手里, 为0时整个chunk可以归还
+  enum {_S_CHUNK_BYTES = __STL_NODE_ALLOCATOR_CHUNK_BYTES};
+  struct _Chunk {
+    _Chunk* _M_next;
+    size_t _M_live;
+    bool _M_from_malloc;    // _Chunk_source failed; malloc_alloc gave it.
+    int _M_inst;            // the instance whose pool carved it
+  };
+  static _Chunk* _S_chunk_list;
+
+  static _Chunk* _S_chunk_of(void* __p)
+    { return (_Chunk*)((size_t)__p & ~((size_t) _S_CHUNK_BYTES - 1)); }
+  // Sets up the header of a fresh chunk and returns its first usable byte.
+  static char* _S_link_chunk(char* __chunk, bool __from_malloc) {
+    _Chunk* __c = (_Chunk*) __chunk;
+    __c->_M_next = _S_chunk_list;
+    __c->_M_live = 0;
+    __c->_M_from_malloc = __from_malloc;
+    __c->_M_inst = inst;
+    _S_chunk_list = __c;
+    return __chunk + _S_align_up(sizeof(_Chunk));
+  }
+  // release_unused with the lock held.
+  static size_t _S_release_unused();
+  // Our memory-pressure callback, registered when the pool first grows.
+  static bool _S_shrink_registered;
+  static size_t _S_shrink(size_t, void*) { return release_unused(); }
+# endif /* __STL_NODE_ALLOCATOR_TRIM */
+
+  // Called, with the lock held, when an object leaves the free lists
+  // and when it comes back.
+# ifdef __STL_NODE_ALLOCATOR_TRIM
+  static void _S_note_alloc(void* __p) { ++_S_chunk_of(__p)->_M_live; }
+  static void _S_note_free(void* __p) { --_S_chunk_of(__p)->_M_live; }
+# else /* __STL_NODE_ALLOCATOR_TRIM */
+  static void _S_note_alloc(void* /* __p */) {}
+  static void _S_note_free(void* /* __p */) {}
+# endif /* __STL_NODE_ALLOCATOR_TRIM */
+
 # ifdef __STL_THREADS
     static _STL_mutex_lock _S_node_allocator_lock;
 # endif
@@ -354,35 +2256,158 @@ private:
             _Lock() { __NODE_ALLOCATOR_LOCK; }
             ~_Lock() { __NODE_ALLOCATOR_UNLOCK; }
     };
+    // Lets go of the lock for a while, where _S_chunk_alloc calls out to
+    // code that may use this allocator.
+    class _Unlock;
+    friend class _Unlock;
+    class _Unlock {
+        public:
+            _Unlock() { __NODE_ALLOCATOR_UNLOCK; }
+            ~_Unlock() { __NODE_ALLOCATOR_LOCK; }
+    };
+    // The constructor and destructor are only there so that an unused
+    // _Null_lock does not draw a warning.
+    class _Null_lock {
+        public:
+            _Null_lock() {}
+            ~_Null_lock() {}
+    };
+
+    // _List_lock guards the free lists, and _Pool_lock guards the pool
+    // (_S_start_free and friends) where the list lock is not enough.
+    // Normally one lock covers both.  With lock-free lists only the
+    // pool is locked.
+# ifdef __STL_NODE_ALLOCATOR_LOCK_FREE
+    typedef _Null_lock _List_lock;
+    typedef _Lock _Pool_lock;
+# else
+    typedef _Lock _List_lock;
+    typedef _Null_lock _Pool_lock;
+# endif
+
+# ifdef __STL_NODE_ALLOCATOR_THREAD_CACHE
+  // Thread caching mode.  Each thread keeps a small magazine of free
+  // objects per size class.  Objects move between a magazine and the
+  // shared _S_free_list in batches of _S_MAGAZINE_BATCH, so the lock is
+  // taken once per batch instead of once per allocate/deallocate.
+  // _S_refill and _S_chunk_alloc remain the backing layer.
+  // 线程缓存: 每个线程每个size class有一个弹匣, 批量与共享free list交换
+  enum {_S_MAGAZINE_BATCH = 16};
+  struct _Magazine {
+    _Obj* _M_head;
+    int _M_count;
+#   ifdef __STL_ALLOC_STATS
+    // Counted here without the lock, and folded into _S_stats whenever
+    // the magazine is exchanged.
+    size_t _M_allocs;
+    size_t _M_frees;
+#   endif
+  };
+  struct _Thread_cache {
+    _Magazine _M_magazine[_NFREELISTS];
+  };
+  static pthread_key_t _S_cache_key;
+  static bool _S_cache_key_initialized;
+
+  // Returns the calling thread's cache, creating it if necessary.
+  static _Thread_cache* _S_get_thread_cache() {
+    _Thread_cache* __cache;
+    if (!_S_cache_key_initialized ||
+        0 == (__cache = (_Thread_cache*) pthread_getspecific(_S_cache_key)))
+      __cache = _S_new_thread_cache();
+    return __cache;
+  }
+  static _Thread_cache* _S_new_thread_cache();
+  // Called on thread exit; hands every cached object back to the
+  // shared free lists.
+  static void _S_cache_destructor(void* __cache);
+  // Moves up to _S_MAGAZINE_BATCH objects of size __n from the shared
+  // free list into the empty magazine __m.  __n is properly aligned.
+  static void _S_fill_magazine(size_t __n, _Magazine* __m);
+  // Moves __count objects from the front of __m back to the shared
+  // free list for size __n.
+  static void _S_drain_magazine(size_t __n, _Magazine* __m, int __count);
+#   ifdef __STL_ALLOC_STATS
+  // Folds the magazine's counters into _S_stats.
+  static void _S_flush_magazine_stats(size_t __n, _Magazine* __m) {
+    __stl_stat_add(&_S_stats._M_class[_S_freelist_index(__n)]._M_allocs,
+                   __m->_M_allocs);
+    __stl_stat_add(&_S_stats._M_class[_S_freelist_index(__n)]._M_frees,
+                   __m->_M_frees);
+    __m->_M_allocs = __m->_M_frees = 0;
+  }
+#   endif
+# endif /* __STL_NODE_ALLOCATOR_THREAD_CACHE */
 
 public:
+# ifdef __STL_ALLOC_STATS
+  struct stats_type {
+    struct _Class {
+      size_t _M_size;         // object size of this class
+      size_t _M_allocs;       // objects handed out
+      size_t _M_frees;        // objects given back
+      size_t _M_refills;      // times the free list was empty
+      size_t _M_bytes_held;   // _M_size * (_M_allocs - _M_frees)
+    } _M_class[_NFREELISTS];
+    size_t _M_nclasses;
+    size_t _M_heap_bytes;       // obtained from malloc and not released
+    size_t _M_growth_bytes;     // of which due to the _S_heap_size >> 4 term
+    size_t _M_pool_bytes;       // left in the pool, not yet carved
+    size_t _M_chunk_allocs;     // times the pool went to malloc
+    size_t _M_malloc_fallbacks; // times malloc failed and malloc_alloc
+                                // (and its out-of-memory handler) was used
+    size_t _M_scavenges;        // times a free object was put back into
+                                // the pool because malloc failed
+    size_t _M_released_bytes;   // given back by release_unused
+  };
+  // Takes a consistent snapshot under the lock.  With per-thread caches
+  // the per-class counts lag by at most one magazine batch per thread.
+  static void get_stats(stats_type& __s);
+private:
+  static stats_type _S_stats;
+public:
+# endif /* __STL_ALLOC_STATS */
 
   /* __n must be > 0      */
-  
+
   static void* allocate(size_t __n)
   {
     void* __ret = 0;
 
+    __STL_ALLOC_TRACE(alloc_tracer::_S_note(__n, alloc_tracer::_S_ALLOCATE));
     if (__n > (size_t) _MAX_BYTES) {
       __ret = malloc_alloc::allocate(__n);
     }
+# ifdef __STL_NODE_ALLOCATOR_THREAD_CACHE
+    else if (threads) {
+      _Magazine* __m =
+        _S_get_thread_cache()->_M_magazine + _S_freelist_index(__n);
+      if (0 == __m->_M_head)
+        _S_fill_magazine(_S_round_up(__n), __m); // 只在交换弹匣时加锁
+      _Obj* __result = __m->_M_head;
+      __m->_M_head = __result -> _M_free_list_link;
+      --__m->_M_count;
+      __STL_ALLOC_STAT(++__m->_M_allocs);
+      __ret = __result;
+    }
+# endif /* __STL_NODE_ALLOCATOR_THREAD_CACHE */
     else {
-      _Obj* __STL_VOLATILE* __my_free_list
-          = _S_free_list + _S_freelist_index(__n);
       // Acquire the lock here with a constructor call.
       // This ensures that it is released in exit or during stack
       // unwinding.
 #     ifndef _NOTHREADS
       /*REFERENCED*/
-      _Lock __lock_instance;
+      _List_lock __lock_instance;
 #     endif
-      _Obj* __RESTRICT __result = *__my_free_list;
-      if (__result == 0)
+      __ret = _S_pop_free(_S_freelist_index(__n));
+      if (__ret == 0) {
+        /*REFERENCED*/
+        _Pool_lock __pool_lock_instance;
         __ret = _S_refill(_S_round_up(__n));
-      else {
-        *__my_free_list = __result -> _M_free_list_link;
-        __ret = __result;
       }
+      _S_note_alloc(__ret);
+      __STL_ALLOC_STAT(__stl_stat_add(
+        &_S_stats._M_class[_S_freelist_index(__n)]._M_allocs, 1));
     }
 
     return __ret;
@@ -392,30 +2417,361 @@ public:
   // 
   static void deallocate(void* __p, size_t __n)
   {
+    __STL_ALLOC_TRACE(
+      alloc_tracer::_S_note(__n, alloc_tracer::_S_DEALLOCATE));
     if (__n > (size_t) _MAX_BYTES)
       malloc_alloc::deallocate(__p, __n);
+# ifdef __STL_NODE_ALLOCATOR_THREAD_CACHE
+    else if (threads) {
+      _Magazine* __m =
+        _S_get_thread_cache()->_M_magazine + _S_freelist_index(__n);
+      _Obj* __q = (_Obj*)__p;
+      __q -> _M_free_list_link = __m->_M_head;
+      __m->_M_head = __q;
+      __STL_ALLOC_STAT(++__m->_M_frees);
+      // Keep one batch around so that alternating allocate/deallocate
+      // does not bounce a batch back and forth.
+      if (++__m->_M_count >= 2 * (int) _S_MAGAZINE_BATCH)
+        _S_drain_magazine(_S_round_up(__n), __m, (int) _S_MAGAZINE_BATCH);
+    }
+# endif /* __STL_NODE_ALLOCATOR_THREAD_CACHE */
     else {
-      _Obj* __STL_VOLATILE*  __my_free_list 
-          = _S_free_list + _S_freelist_index(__n);
       _Obj* __q = (_Obj*)__p;
 
       // acquire lock
 #       ifndef _NOTHREADS
       /*REFERENCED*/
-      _Lock __lock_instance;
+      _List_lock __lock_instance;
 #       endif /* _NOTHREADS */
-      __q -> _M_free_list_link = *__my_free_list; 
-      *__my_free_list = __q;
+      _S_push_free(_S_freelist_index(__n), __q, __q);
+      _S_note_free(__q);
+      __STL_ALLOC_STAT(__stl_stat_add(
+        &_S_stats._M_class[_S_freelist_index(__n)]._M_frees, 1));
       // lock is released here
     }
   }
 
   static void* reallocate(void* __p, size_t __old_sz, size_t __new_sz);
 
+  // The extended protocol; see _Alloc_extensions.  A small object may
+  // use its whole size class.
+  // A trace records __got, the size the caller will give back.
+  static void* allocate_at_least(size_t __n, size_t& __got)
+  {
+    if (__n > (size_t) _MAX_BYTES) {
+      void* __p = malloc_alloc::allocate_at_least(__n, __got);
+      __STL_ALLOC_TRACE(
+        alloc_tracer::_S_note(__got, alloc_tracer::_S_ALLOCATE));
+      return __p;
+    }
+    __got = _S_round_up(__n);
+    return allocate(__got);
+  }
+
+  static bool try_expand(void* __p, size_t __old_sz, size_t __new_sz)
+  {
+    bool __ok;
+
+    if (__old_sz > (size_t) _MAX_BYTES)
+      __ok = malloc_alloc::try_expand(__p, __old_sz, __new_sz);
+    else
+      __ok = __new_sz <= (size_t) _MAX_BYTES &&
+             _S_round_up(__new_sz) == _S_round_up(__old_sz);
+    __STL_ALLOC_TRACE(
+      if (__ok) alloc_tracer::_S_note_resize(__old_sz, __new_sz));
+    return __ok;
+  }
+
+  // Objects in the pool are aligned on _ALIGN; more than that comes
+  // from malloc_alloc.
+  static void* allocate_aligned(size_t __n, size_t __align)
+  {
+    if (__align <= (size_t) _ALIGN)
+      return allocate(__n);
+    return malloc_alloc::allocate_aligned(__n, __align);
+  }
+
+  static void deallocate_aligned(void* __p, size_t __n, size_t __align)
+  {
+    if (__align <= (size_t) _ALIGN)
+      deallocate(__p, __n);
+    else
+      malloc_alloc::deallocate_aligned(__p, __n);
+  }
+
+  // Takes the lock once for the whole batch, and asks the pool for the
+  // rest of the batch at once when the free list runs dry.  Per-thread
+  // caches already lock once per magazine, so they just loop.
+  // 批量分配: 一次加锁, free list 空了就一次取够剩下的
+  static void allocate_n_nodes(size_t __n, size_t __count, void** __out);
+
+  // Returns every chunk with no live objects to malloc and answers the
+  // number of bytes given back.  Objects held in per-thread caches keep
+  // their chunks alive.  Without __STL_NODE_ALLOCATOR_TRIM the pool
+  // cannot tell which chunks are free, and this always returns 0.
+  // With it, this is also registered with memory_pressure.
+  // 归还完全空闲的chunk, 返回归还的字节数
+  static size_t release_unused();
+
+# ifdef __STL_NODE_ALLOCATOR_TRIM
+  // The instance that carved __p, an object of at most _MAX_BYTES.
+  // Chunks of every instance look alike, so any instance can tell.
+  static int _S_owner(void* __p) { return _S_chunk_of(__p)->_M_inst; }
+# endif
+
 } ;
 
-typedef __default_alloc_template<__NODE_ALLOCATOR_THREADS, 0> alloc;
+#ifdef __STL_NODE_ALLOCATOR_SHARDED
+
+// Forwards a call to instance __s of __default_alloc_template, one of
+// __first ... __first + __count - 1, by binary search on __s.
+template <bool __threads, int __first, int __count>
+struct _Node_alloc_shards {
+  enum {_S_HALF = __count / 2};
+  typedef _Node_alloc_shards<__threads, __first, _S_HALF> _Low;
+  typedef _Node_alloc_shards<__threads, __first + _S_HALF, __count - _S_HALF>
+          _High;
+
+  static void* allocate(int __s, size_t __n) {
+    return __s < __first + _S_HALF ? _Low::allocate(__s, __n)
+                                   : _High::allocate(__s, __n);
+  }
+  static void deallocate(int __s, void* __p, size_t __n) {
+    if (__s < __first + _S_HALF) _Low::deallocate(__s, __p, __n);
+    else _High::deallocate(__s, __p, __n);
+  }
+  static void allocate_n_nodes(int __s, size_t __n, size_t __k, void** __out) {
+    if (__s < __first + _S_HALF) _Low::allocate_n_nodes(__s, __n, __k, __out);
+    else _High::allocate_n_nodes(__s, __n, __k, __out);
+  }
+  static size_t release_unused()
+    { return _Low::release_unused() + _High::release_unused(); }
+# ifdef __STL_ALLOC_STATS
+  template <class _Stats>
+  static void _S_add_stats(_Stats& __sum)
+    { _Low::_S_add_stats(__sum); _High::_S_add_stats(__sum); }
+# endif
+};
+
+template <bool __threads, int __inst>
+struct _Node_alloc_shards<__threads, __inst, 1> {
+  typedef __default_alloc_template<__threads, __inst> _Alloc;
+
+  static void* allocate(int, size_t __n)
+    { return _Alloc::allocate(__n); }
+  static void deallocate(int, void* __p, size_t __n)
+    { _Alloc::deallocate(__p, __n); }
+  static void allocate_n_nodes(int, size_t __n, size_t __k, void** __out)
+    { _Alloc::allocate_n_nodes(__n, __k, __out); }
+  static size_t release_unused()
+    { return _Alloc::release_unused(); }
+# ifdef __STL_ALLOC_STATS
+  // The shards' stats_types are distinct types of the same shape.
+  template <class _Stats>
+  static void _S_add_stats(_Stats& __sum) {
+    typename _Alloc::stats_type __s;
+    size_t __i;
+
+    _Alloc::get_stats(__s);
+    for (__i = 0; __i < __s._M_nclasses; ++__i) {
+      __sum._M_class[__i]._M_size = __s._M_class[__i]._M_size;
+      __sum._M_class[__i]._M_allocs += __s._M_class[__i]._M_allocs;
+      __sum._M_class[__i]._M_frees += __s._M_class[__i]._M_frees;
+      __sum._M_class[__i]._M_refills += __s._M_class[__i]._M_refills;
+      __sum._M_class[__i]._M_bytes_held += __s._M_class[__i]._M_bytes_held;
+    }
+    __sum._M_nclasses = __s._M_nclasses;
+    __sum._M_heap_bytes += __s._M_heap_bytes;
+    __sum._M_growth_bytes += __s._M_growth_bytes;
+    __sum._M_pool_bytes += __s._M_pool_bytes;
+    __sum._M_chunk_allocs += __s._M_chunk_allocs;
+    __sum._M_malloc_fallbacks += __s._M_malloc_fallbacks;
+    __sum._M_scavenges += __s._M_scavenges;
+    __sum._M_released_bytes += __s._M_released_bytes;
+  }
+# endif
+};
+
+// Sharded mode.  The node allocator is split into
+// __STL_NODE_ALLOCATOR_SHARDS instances of __default_alloc_template,
+// each with its own free lists, pool and lock, and a thread allocates
+// from the shard its id hashes to.  An object goes back to the shard
+// that carved it, which its chunk header names, so memory does not
+// drift from the threads that allocate to the threads that free.
+// 分片模式: 每个分片是一个独立的实例, 各有自己的free list、内存池和锁;
+// 按线程id选分片, 释放时回到chunk头部记录的那个分片
+template <bool threads, int inst>
+class __sharded_alloc_template {
+
+private:
+  enum {_S_SHARDS = __STL_NODE_ALLOCATOR_SHARDS};
+  // Shard __i is instance _S_FIRST + __i, well away from the instance
+  // numbers code picks for itself.  The shards still take their size
+  // classes and chunk source from inst; see __node_alloc_policy_inst.
+  enum {_S_FIRST = __stl_shard_inst_base + inst * _S_SHARDS};
+  typedef _Node_alloc_shards<threads, _S_FIRST, _S_SHARDS> _Shards;
+  typedef __default_alloc_template<threads, _S_FIRST> _First;
+  typedef __node_alloc_size_policy<inst> _Size_classes;
+  enum {_ALIGN = _Size_classes::_ALIGN};
+  enum {_MAX_BYTES = _Size_classes::_MAX_BYTES};
+
+  // pthread_t is usually the address of the thread's descriptor, and
+  // those differ mostly in their high bits, so fold them down.
+  static int _S_current_shard() {
+    if (!threads)
+      return _S_FIRST;
+    size_t __id = (size_t) pthread_self();
+    __id ^= __id >> 21;
+    __id ^= __id >> 13;
+    __id ^= __id >> 7;
+    return _S_FIRST + (int) (__id % (size_t) _S_SHARDS);
+  }
+
+public:
+# ifdef __STL_ALLOC_STATS
+  typedef typename _First::stats_type stats_type;
+  // Sums the shards' statistics.
+  static void get_stats(stats_type& __s) {
+    memset((void*) &__s, 0, sizeof(__s));
+    _Shards::_S_add_stats(__s);
+  }
+# endif
+
+  static void* allocate(size_t __n)
+    { return _Shards::allocate(_S_current_shard(), __n); }
+
+  static void deallocate(void* __p, size_t __n)
+  {
+    if (__n > (size_t) _MAX_BYTES) {
+      __STL_ALLOC_TRACE(
+        alloc_tracer::_S_note(__n, alloc_tracer::_S_DEALLOCATE));
+      malloc_alloc::deallocate(__p, __n);
+    } else
+      _Shards::deallocate(_First::_S_owner(__p), __p, __n);
+  }
+
+  static void* reallocate(void* __p, size_t __old_sz, size_t __new_sz)
+  {
+    void* __result;
+
+    if (__old_sz > (size_t) _MAX_BYTES && __new_sz > (size_t) _MAX_BYTES) {
+      __STL_ALLOC_TRACE(alloc_tracer::_S_note_resize(__old_sz, __new_sz));
+      return realloc(__p, __new_sz);
+    }
+    if (try_expand(__p, __old_sz, __new_sz))
+      return __p;
+    __result = allocate(__new_sz);
+    memcpy(__result, __p, __new_sz > __old_sz ? __old_sz : __new_sz);
+    deallocate(__p, __old_sz);
+    return __result;
+  }
+
+  static void* allocate_at_least(size_t __n, size_t& __got)
+  {
+    if (__n > (size_t) _MAX_BYTES) {
+      void* __p = malloc_alloc::allocate_at_least(__n, __got);
+      __STL_ALLOC_TRACE(
+        alloc_tracer::_S_note(__got, alloc_tracer::_S_ALLOCATE));
+      return __p;
+    }
+    __got = _Size_classes::_S_round_up(__n);
+    return allocate(__got);
+  }
+
+  static bool try_expand(void* __p, size_t __old_sz, size_t __new_sz)
+    { return _First::try_expand(__p, __old_sz, __new_sz); }
+
+  static void* allocate_aligned(size_t __n, size_t __align)
+  {
+    if (__align <= (size_t) _ALIGN)
+      return allocate(__n);
+    return malloc_alloc::allocate_aligned(__n, __align);
+  }
+
+  static void deallocate_aligned(void* __p, size_t __n, size_t __align)
+  {
+    if (__align <= (size_t) _ALIGN)
+      deallocate(__p, __n);
+    else
+      malloc_alloc::deallocate_aligned(__p, __n);
+  }
+
+  // A batch comes from the caller's shard alone; its objects may still
+  // be freed from any thread.
+  static void allocate_n_nodes(size_t __n, size_t __count, void** __out)
+    { _Shards::allocate_n_nodes(_S_current_shard(), __n, __count, __out); }
+
+  // Trims every shard.  Each shard is also registered with
+  // memory_pressure on its own.
+  static size_t release_unused() { return _Shards::release_unused(); }
+};
+
+#ifdef __STL_CLASS_PARTIAL_SPECIALIZATION
+template <bool __threads, int __inst>
+struct _Alloc_extensions<__sharded_alloc_template<__threads, __inst> > {
+  typedef __sharded_alloc_template<__threads, __inst> _Alloc;
+  static void* allocate_at_least(size_t __n, size_t& __got)
+    { return _Alloc::allocate_at_least(__n, __got); }
+  static bool try_expand(void* __p, size_t __old_sz, size_t __new_sz)
+    { return _Alloc::try_expand(__p, __old_sz, __new_sz); }
+  static void* allocate_aligned(size_t __n, size_t __align)
+    { return _Alloc::allocate_aligned(__n, __align); }
+  static void deallocate_aligned(void* __p, size_t __n, size_t __align)
+    { _Alloc::deallocate_aligned(__p, __n, __align); }
+  static void allocate_n_nodes(size_t __n, size_t __count, void** __out)
+    { _Alloc::allocate_n_nodes(__n, __count, __out); }
+};
+#endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */
+
+template <bool __threads, int __inst>
+inline bool operator==(const __sharded_alloc_template<__threads, __inst>&,
+                       const __sharded_alloc_template<__threads, __inst>&)
+{
+  return true;
+}
+
+# ifdef __STL_FUNCTION_TMPL_PARTIAL_ORDER
+template <bool __threads, int __inst>
+inline bool operator!=(const __sharded_alloc_template<__threads, __inst>&,
+                       const __sharded_alloc_template<__threads, __inst>&)
+{
+  return false;
+}
+# endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
+
+// Containers that ask for the default allocator get the shards.
+# define __NODE_ALLOCATOR \
+    __sharded_alloc_template<__NODE_ALLOCATOR_THREADS, 0>
+#else
+# define __NODE_ALLOCATOR \
+    __default_alloc_template<__NODE_ALLOCATOR_THREADS, 0>
+#endif /* __STL_NODE_ALLOCATOR_SHARDED */
+
+#ifdef __STL_USE_DEBUG_ALLOC
+typedef debug_alloc<__NODE_ALLOCATOR > alloc;
+typedef debug_alloc<__default_alloc_template<false, 0> > single_client_alloc;
+#else
+typedef __NODE_ALLOCATOR alloc;
 typedef __default_alloc_template<false, 0> single_client_alloc;
+#endif
+#undef __NODE_ALLOCATOR
+
+#ifdef __STL_CLASS_PARTIAL_SPECIALIZATION
+template <bool __threads, int __inst>
+struct _Alloc_extensions<__default_alloc_template<__threads, __inst> > {
+  typedef __default_alloc_template<__threads, __inst> _Alloc;
+  static void* allocate_at_least(size_t __n, size_t& __got)
+    { return _Alloc::allocate_at_least(__n, __got); }
+  static bool try_expand(void* __p, size_t __old_sz, size_t __new_sz)
+    { return _Alloc::try_expand(__p, __old_sz, __new_sz); }
+  static void* allocate_aligned(size_t __n, size_t __align)
+    { return _Alloc::allocate_aligned(__n, __align); }
+  static void deallocate_aligned(void* __p, size_t __n, size_t __align)
+    { _Alloc::deallocate_aligned(__p, __n, __align); }
+  static void allocate_n_nodes(size_t __n, size_t __count, void** __out)
+    { _Alloc::allocate_n_nodes(__n, __count, __out); }
+};
+#endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */
 
 template <bool __threads, int __inst>
 inline bool operator==(const __default_alloc_template<__threads, __inst>&,
@@ -460,35 +2816,63 @@ __default_alloc_template<__threads, __inst>::_S_chunk_alloc(size_t __size,
         _S_start_free += __total_bytes;
         return(__result);
     } else { // 无法提供一个区块
-        size_t __bytes_to_get = 
-	  2 * __total_bytes + _S_round_up(_S_heap_size >> 4); // 附加量,随着配置次数增大
+#     ifdef __STL_NODE_ALLOCATOR_TRIM
+        if (!_S_shrink_registered) {
+            // Not under our lock: memory_pressure holds its own while
+            // the callbacks run, and they may free into this allocator.
+            // (From a callback it only queues _S_shrink for later.)
+            // The pool may change meanwhile, so start over.
+            _S_shrink_registered = true;
+            {
+                /*REFERENCED*/
+                _Unlock __unlock_instance;
+                memory_pressure::add_shrink_callback(
+                  _S_shrink, 0, memory_pressure::priority_pool);
+            }
+            return(_S_chunk_alloc(__size, __nobjs));
+        }
+        // Chunks must all be the same size so that _S_chunk_of works.
+        size_t __bytes_to_get = (size_t) _S_CHUNK_BYTES;
+        bool __from_malloc = false;
+#     else
+        size_t __bytes_to_get = _Chunk_source::_S_good_size(
+	  2 * __total_bytes + _S_align_up(_S_heap_size >> 4)); // 附加量,随着配置次数增大
+        __STL_ALLOC_STAT(_S_stats._M_growth_bytes +=
+                           _S_align_up(_S_heap_size >> 4));
+#     endif
+        __STL_ALLOC_STAT(++_S_stats._M_chunk_allocs);
         // Try to make use of the left-over piece.
         if (__bytes_left > 0) { // 内存池的剩余空间先给适当的free-list
-            _Obj* __STL_VOLATILE* __my_free_list =
-                        _S_free_list + _S_freelist_index(__bytes_left);
+            // The piece goes to the largest class it can hold.
+            size_t __index = _S_freelist_index(__bytes_left);
+            if (_Size_classes::_S_class_size(__index) > __bytes_left)
+                --__index;
         // 调整free-list将内存中的参与空间编入
-            ((_Obj*)_S_start_free) -> _M_free_list_link = *__my_free_list; // 
-            *__my_free_list = (_Obj*)_S_start_free; 
+            _S_push_free(__index, (_Obj*)_S_start_free, (_Obj*)_S_start_free);
         }
         // 配置heap空间，用来补充内存池
-        _S_start_free = (char*)malloc(__bytes_to_get);
+#     ifdef __STL_NODE_ALLOCATOR_TRIM
+        _S_start_free = (char*)_Chunk_source::_S_allocate(__bytes_to_get,
+                                                          __bytes_to_get);
+#     else
+        _S_start_free = (char*)_Chunk_source::_S_allocate(__bytes_to_get, 0);
+#     endif
         if (0 == _S_start_free) { // malloc失败
             size_t __i;
-            _Obj* __STL_VOLATILE* __my_free_list;
 	    _Obj* __p;
             // Try to make do with what we have.  That can't
             // hurt.  We do not try smaller requests, since that tends
             // to result in disaster on multi-process machines. // why?
             // 搜寻适当的free lists
-            for (__i = __size;
-                 __i <= (size_t) _MAX_BYTES;
-                 __i += (size_t) _ALIGN) {
-                __my_free_list = _S_free_list + _S_freelist_index(__i);
-                __p = *__my_free_list;
+            for (__i = _S_freelist_index(__size);
+                 __i < (size_t) _NFREELISTS;
+                 ++__i) {
+                __p = _S_pop_free(__i);
                 if (0 != __p) {
-                    *__my_free_list = __p -> _M_free_list_link;
+                    __STL_ALLOC_STAT(++_S_stats._M_scavenges);
                     _S_start_free = (char*)__p; // char
-                    _S_end_free = _S_start_free + __i;
+                    _S_end_free = _S_start_free
+                                  + _Size_classes::_S_class_size(__i);
                     return(_S_chunk_alloc(__size, __nobjs)); // 任何残余零头都将编入适当的free-lists中备用
                     // Any leftover piece will eventually make it to the
                     // right free list.
@@ -496,13 +2880,44 @@ __default_alloc_template<__threads, __inst>::_S_chunk_alloc(size_t __size,
             }
       // 山穷水尽给一级配置器看能不能有办法
 	    _S_end_free = 0;	// In case of exception.
-            _S_start_free = (char*)malloc_alloc::allocate(__bytes_to_get);
+            __STL_ALLOC_STAT(++_S_stats._M_malloc_fallbacks);
+#         ifdef __STL_NODE_ALLOCATOR_TRIM
+            __from_malloc = true;
+#         endif
+            char* __chunk;
+            {
+                // Without our lock, since malloc_alloc may run the
+                // memory-pressure callbacks, which may free into this
+                // allocator or trim it.
+                /*REFERENCED*/
+                _Unlock __unlock_instance;
+#         ifdef __STL_NODE_ALLOCATOR_TRIM
+                __chunk = (char*)
+                  malloc_alloc::allocate_aligned(__bytes_to_get,
+                                                 __bytes_to_get);
+#         else
+                __chunk = (char*)malloc_alloc::allocate(__bytes_to_get);
+#         endif
+            }
             // This should either throw an
             // exception or remedy the situation.  Thus we assume it
             // succeeded.
+            if (_S_start_free != _S_end_free) {
+                // Another thread refilled the pool meanwhile.
+#             ifdef __STL_NODE_ALLOCATOR_TRIM
+                malloc_alloc::deallocate_aligned(__chunk, __bytes_to_get);
+#             else
+                malloc_alloc::deallocate(__chunk, __bytes_to_get);
+#             endif
+                return(_S_chunk_alloc(__size, __nobjs));
+            }
+            _S_start_free = __chunk;
         }
         _S_heap_size += __bytes_to_get;
         _S_end_free = _S_start_free + __bytes_to_get;
+#     ifdef __STL_NODE_ALLOCATOR_TRIM
+        _S_start_free = _S_link_chunk(_S_start_free, __from_malloc);
+#     endif
         return(_S_chunk_alloc(__size, __nobjs));
     }
 }
@@ -513,26 +2928,27 @@ __default_alloc_template<__threads, __inst>::_S_chunk_alloc(size_t __size,
 /* We hold the allocation lock.                                         */
 // __n 已经扩充为8的倍数
 template <bool __threads, int __inst>
-void*
-__default_alloc_template<__threads, __inst>::_S_refill(size_t __n)
+int
+__default_alloc_template<__threads, __inst>::_S_refill_n(size_t __n,
+                                                         int __want,
+                                                         void** __out)
 {
-    int __nobjs = 20; // 取20个新节点
+    int __nobjs = __want < 20 ? 20 : __want; // 至少取20个新节点
     char* __chunk = _S_chunk_alloc(__n, __nobjs);
-    _Obj* __STL_VOLATILE* __my_free_list;
-    _Obj* __result;
+    _Obj* __first_obj;
     _Obj* __current_obj;
     _Obj* __next_obj;
     int __i;
 
-    if (1 == __nobjs) return(__chunk); // 若只取得1个节点 直接给调用者用， 不再变free-lists
-    // 准备纳入新节点
-    __my_free_list = _S_free_list + _S_freelist_index(__n);
-
+    __STL_ALLOC_STAT(++_S_stats._M_class[_S_freelist_index(__n)]._M_refills);
+    if (__nobjs < __want) __want = __nobjs;
+    for (__i = 0; __i < __want; __i++) // 给客户端用的
+      __out[__i] = __chunk + __i * __n;
+    if (__nobjs == __want) return(__want); // 全部给调用者， 不再编入free-lists
     /* Build free list in chunk */
-      __result = (_Obj*)__chunk; // 给客户端用的
-      *__my_free_list = __next_obj = (_Obj*)(__chunk + __n);
+      __first_obj = __next_obj = (_Obj*)(__chunk + __want * __n);
     // free-lists的各节点串起来
-      for (__i = 1; ; __i++) { 
+      for (__i = __want; ; __i++) { 
         __current_obj = __next_obj; 
         __next_obj = (_Obj*)((char*)__next_obj + __n);
         if (__nobjs - 1 == __i) {
@@ -542,7 +2958,66 @@ __default_alloc_template<__threads, __inst>::_S_refill(size_t __n)
             __current_obj -> _M_free_list_link = __next_obj;
         }
       }
-    return(__result);
+    // 准备纳入新节点
+    _S_push_free(_S_freelist_index(__n), __first_obj, __current_obj);
+    return(__want);
+}
+
+template <bool __threads, int __inst>
+void
+__default_alloc_template<__threads, __inst>::allocate_n_nodes(size_t __n,
+                                                              size_t __count,
+                                                              void** __out)
+{
+    size_t __i = 0;
+
+    if (__n > (size_t) _MAX_BYTES
+#     ifdef __STL_NODE_ALLOCATOR_THREAD_CACHE
+        || __threads
+#     endif
+       ) {
+        __STL_TRY {
+            for ( ; __i < __count; ++__i)
+                __out[__i] = allocate(__n);
+        }
+        __STL_UNWIND(while (__i > 0) deallocate(__out[--__i], __n));
+        return;
+    }
+
+    __STL_ALLOC_TRACE(for (size_t __k = 0; __k < __count; ++__k)
+      alloc_tracer::_S_note(__n, alloc_tracer::_S_ALLOCATE));
+    size_t __index = _S_freelist_index(__n);
+#   ifndef _NOTHREADS
+    /*REFERENCED*/
+    _List_lock __lock_instance;
+#   endif
+    __STL_TRY {
+        while (__i < __count) {
+            _Obj* __p = _S_pop_free(__index);
+            if (0 != __p) {
+                // Noted at once: trimming may run while the pool refills.
+                _S_note_alloc(__p);
+                __out[__i++] = __p;
+                continue;
+            }
+            size_t __want = __count - __i;
+            if (__want > (size_t) _S_REFILL_MAX)
+                __want = (size_t) _S_REFILL_MAX;
+            /*REFERENCED*/
+            _Pool_lock __pool_lock_instance;
+            int __got = _S_refill_n(_S_round_up(__n), (int) __want,
+                                    __out + __i);
+            for ( ; __got > 0; --__got)
+                _S_note_alloc(__out[__i++]);
+        }
+    }
+    __STL_UNWIND(while (__i > 0) {
+                   _Obj* __q = (_Obj*) __out[--__i];
+                   _S_push_free(__index, __q, __q);
+                   _S_note_free(__q);
+                 });
+    __STL_ALLOC_STAT(__stl_stat_add(&_S_stats._M_class[__index]._M_allocs,
+                                    __count));
 }
 
 template <bool threads, int inst>
@@ -555,9 +3030,13 @@ __default_alloc_template<threads, inst>::reallocate(void* __p,
     size_t __copy_sz;
 
     if (__old_sz > (size_t) _MAX_BYTES && __new_sz > (size_t) _MAX_BYTES) {
+        __STL_ALLOC_TRACE(alloc_tracer::_S_note_resize(__old_sz, __new_sz));
         return(realloc(__p, __new_sz));
     }
-    if (_S_round_up(__old_sz) == _S_round_up(__new_sz)) return(__p);
+    if (_S_round_up(__old_sz) == _S_round_up(__new_sz)) {
+        __STL_ALLOC_TRACE(alloc_tracer::_S_note_resize(__old_sz, __new_sz));
+        return(__p);
+    }
     __result = allocate(__new_sz);
     __copy_sz = __new_sz > __old_sz? __old_sz : __new_sz;
     memcpy(__result, __p, __copy_sz);
@@ -565,6 +3044,210 @@ __default_alloc_template<threads, inst>::reallocate(void* __p,
     return(__result);
 }
 
+template <bool __threads, int __inst>
+size_t
+__default_alloc_template<__threads, __inst>::release_unused()
+{
+#   ifdef __STL_NODE_ALLOCATOR_TRIM
+    /*REFERENCED*/
+    _Lock __lock_instance;
+    return _S_release_unused();
+#   else
+    return 0;
+#   endif
+}
+
+#ifdef __STL_NODE_ALLOCATOR_TRIM
+template <bool __threads, int __inst>
+size_t
+__default_alloc_template<__threads, __inst>::_S_release_unused()
+{
+    size_t __released = 0;
+    _Chunk* __pool_chunk;
+    _Chunk* __c;
+    _Chunk** __link;
+    _Obj* __STL_VOLATILE* __obj_link;
+    _Obj* __q;
+    int __i;
+
+    // The rest of the pool is not on any free list, and is not counted
+    // as live, so its chunk has to be kept explicitly.
+    __pool_chunk = _S_start_free < _S_end_free ? _S_chunk_of(_S_start_free)
+                                               : 0;
+    // First unlink the free objects of every chunk that is going away,
+    for (__i = 0; __i < (int) _NFREELISTS; ++__i) {
+        __obj_link = _S_free_list + __i;
+        while (0 != (__q = *__obj_link)) {
+            __c = _S_chunk_of(__q);
+            if (0 == __c->_M_live && __c != __pool_chunk)
+                *__obj_link = __q -> _M_free_list_link;
+            else
+                __obj_link = &__q -> _M_free_list_link;
+        }
+    }
+    // then give the chunks themselves back.
+    __link = &_S_chunk_list;
+    while (0 != (__c = *__link)) {
+        if (0 == __c->_M_live && __c != __pool_chunk) {
+            *__link = __c->_M_next;
+            if (__c->_M_from_malloc)
+                malloc_alloc::deallocate_aligned(__c, (size_t) _S_CHUNK_BYTES);
+            else
+                _Chunk_source::_S_deallocate(__c, (size_t) _S_CHUNK_BYTES,
+                                             (size_t) _S_CHUNK_BYTES);
+            _S_heap_size -= (size_t) _S_CHUNK_BYTES;
+            __released += (size_t) _S_CHUNK_BYTES;
+        } else {
+            __link = &__c->_M_next;
+        }
+    }
+    __STL_ALLOC_STAT(_S_stats._M_released_bytes += __released);
+    return __released;
+}
+
+template <bool __threads, int __inst>
+bool __default_alloc_template<__threads, __inst>::_S_shrink_registered
+  = false;
+#endif /* __STL_NODE_ALLOCATOR_TRIM */
+
+#ifdef __STL_ALLOC_STATS
+template <bool __threads, int __inst>
+void
+__default_alloc_template<__threads, __inst>::get_stats(stats_type& __s)
+{
+    size_t __i;
+    /*REFERENCED*/
+    _Lock __lock_instance;
+
+    __s = _S_stats;
+    for (__i = 0; __i < (size_t) _NFREELISTS; ++__i) {
+        __s._M_class[__i]._M_size = _Size_classes::_S_class_size(__i);
+        __s._M_class[__i]._M_bytes_held = __s._M_class[__i]._M_size
+          * (__s._M_class[__i]._M_allocs - __s._M_class[__i]._M_frees);
+    }
+    __s._M_nclasses = (size_t) _NFREELISTS;
+    __s._M_heap_bytes = _S_heap_size;
+    __s._M_pool_bytes = _S_end_free - _S_start_free;
+}
+
+template <bool __threads, int __inst>
+typename __default_alloc_template<__threads, __inst>::stats_type
+__default_alloc_template<__threads, __inst>::_S_stats;
+#endif /* __STL_ALLOC_STATS */
+
+#ifdef __STL_NODE_ALLOCATOR_THREAD_CACHE
+
+template <bool __threads, int __inst>
+typename __default_alloc_template<__threads, __inst>::_Thread_cache*
+__default_alloc_template<__threads, __inst>::_S_new_thread_cache()
+{
+    _Thread_cache* __result;
+    {
+        /*REFERENCED*/
+        _Lock __lock_instance;
+        if (!_S_cache_key_initialized) {
+            if (pthread_key_create(&_S_cache_key, _S_cache_destructor)) {
+                __THROW_BAD_ALLOC;
+            }
+            _S_cache_key_initialized = true;
+        }
+    }
+    __result = (_Thread_cache*) malloc_alloc::allocate(sizeof(_Thread_cache));
+    memset((void*) __result, 0, sizeof(_Thread_cache));
+    if (pthread_setspecific(_S_cache_key, __result)) {
+        malloc_alloc::deallocate(__result, sizeof(_Thread_cache));
+        __THROW_BAD_ALLOC;
+    }
+    return __result;
+}
+
+template <bool __threads, int __inst>
+void
+__default_alloc_template<__threads, __inst>::_S_cache_destructor(void* __p)
+{
+    _Thread_cache* __cache = (_Thread_cache*) __p;
+    int __i;
+
+    for (__i = 0; __i < (int) _NFREELISTS; ++__i) {
+        _Magazine* __m = __cache->_M_magazine + __i;
+        if (0 != __m->_M_count)
+            _S_drain_magazine(_Size_classes::_S_class_size(__i),
+                              __m, __m->_M_count);
+#       ifdef __STL_ALLOC_STATS
+        else
+            _S_flush_magazine_stats(_Size_classes::_S_class_size(__i), __m);
+#       endif
+    }
+    malloc_alloc::deallocate(__cache, sizeof(_Thread_cache));
+}
+
+template <bool __threads, int __inst>
+void
+__default_alloc_template<__threads, __inst>::_S_fill_magazine(size_t __n,
+                                                              _Magazine* __m)
+{
+    size_t __index = _S_freelist_index(__n);
+    _Obj* __head;
+    _Obj* __q;
+    int __count = 1;
+    /*REFERENCED*/
+    _List_lock __lock_instance;
+
+    if (0 == (__head = _S_pop_free(__index))) {
+        // _S_refill hands one object back and leaves the rest of the
+        // new chunk on the shared list, where we pick them up below.
+        /*REFERENCED*/
+        _Pool_lock __pool_lock_instance;
+        __head = (_Obj*) _S_refill(__n);
+    }
+    __head -> _M_free_list_link = 0;
+    while (__count < (int) _S_MAGAZINE_BATCH
+           && 0 != (__q = _S_pop_free(__index))) {
+        __q -> _M_free_list_link = __head;
+        __head = __q;
+        ++__count;
+    }
+    for (__q = __head; 0 != __q; __q = __q -> _M_free_list_link)
+        _S_note_alloc(__q);
+    __STL_ALLOC_STAT(_S_flush_magazine_stats(__n, __m));
+    __m->_M_head = __head;
+    __m->_M_count = __count;
+}
+
+template <bool __threads, int __inst>
+void
+__default_alloc_template<__threads, __inst>::_S_drain_magazine(size_t __n,
+                                                               _Magazine* __m,
+                                                               int __count)
+{
+    _Obj* __first = __m->_M_head;
+    _Obj* __last = __first;
+    int __i;
+
+    // Find the end of the batch without holding the lock.
+    for (__i = 1; __i < __count; ++__i)
+        __last = __last -> _M_free_list_link;
+    __m->_M_head = __last -> _M_free_list_link;
+    __m->_M_count -= __count;
+
+    /*REFERENCED*/
+    _List_lock __lock_instance;
+    _Obj* __q = __first;
+    for (__i = 0; __i < __count; ++__i, __q = __q -> _M_free_list_link)
+        _S_note_free(__q);
+    __STL_ALLOC_STAT(_S_flush_magazine_stats(__n, __m));
+    _S_push_free(_S_freelist_index(__n), __first, __last);
+}
+
+template <bool __threads, int __inst>
+pthread_key_t __default_alloc_template<__threads, __inst>::_S_cache_key;
+
+template <bool __threads, int __inst>
+bool __default_alloc_template<__threads, __inst>::_S_cache_key_initialized
+    = false;
+
+#endif /* __STL_NODE_ALLOCATOR_THREAD_CACHE */
+
 #ifdef __STL_THREADS
     template <bool __threads, int __inst>
     _STL_mutex_lock
@@ -582,18 +3265,27 @@ char* __default_alloc_template<__threads, __inst>::_S_end_free = 0;
 template <bool __threads, int __inst>
 size_t __default_alloc_template<__threads, __inst>::_S_heap_size = 0;
 
+#ifdef __STL_NODE_ALLOCATOR_TRIM
+template <bool __threads, int __inst>
+typename __default_alloc_template<__threads, __inst>::_Chunk*
+__default_alloc_template<__threads, __inst>::_S_chunk_list = 0;
+#endif
+
+#ifdef __STL_NODE_ALLOCATOR_LOCK_FREE
+template <bool __threads, int __inst>
+_STL_lock_free_stack
+__default_alloc_template<__threads, __inst> ::_S_free_list[
+    __default_alloc_template<__threads, __inst>::_NFREELISTS
+];
+#else
 template <bool __threads, int __inst>
 typename __default_alloc_template<__threads, __inst>::_Obj* __STL_VOLATILE
 __default_alloc_template<__threads, __inst> ::_S_free_list[
-# if defined(__SUNPRO_CC) || defined(__GNUC__) || defined(__HP_aCC)
-    _NFREELISTS
-# else
     __default_alloc_template<__threads, __inst>::_NFREELISTS
-# endif
-] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, };
-// The 16 zeros are necessary to make version 4.1 of the SunPro
-// compiler happy.  Otherwise it appears to allocate too little
-// space for the array.
+] = { 0 };
+#endif
+// The number of lists now depends on the size class policy, so we can
+// no longer spell out one zero per list for the SunPro 4.1 compiler.
 
 #endif /* ! __USE_MALLOC */
 
@@ -634,13 +3326,29 @@ public:
   // __n is permitted to be 0.  The C++ standard says nothing about what
   // the return value is when __n == 0.
   _Tp* allocate(size_type __n, const void* = 0) {
-    return __n != 0 ? static_cast<_Tp*>(_Alloc::allocate(__n * sizeof(_Tp))) 
-                    : 0;
+    _Tp* __result =
+      __n != 0 ? static_cast<_Tp*>(_Alloc::allocate(__n * sizeof(_Tp))) : 0;
+    __STL_ALLOC_SAMPLE(
+      alloc_sampler::_S_note_allocate(__result, __n * sizeof(_Tp)));
+    return __result;
   }
 
   // __p is not permitted to be a null pointer.
-  void deallocate(pointer __p, size_type __n)
-    { _Alloc::deallocate(__p, __n * sizeof(_Tp)); }
+  void deallocate(pointer __p, size_type __n) {
+    __STL_ALLOC_SAMPLE(alloc_sampler::_S_note_deallocate(__p));
+    _Alloc::deallocate(__p, __n * sizeof(_Tp));
+  }
+
+  // Extensions; see _Alloc_extensions.  __got is set to the number of
+  // objects the block can hold, and deallocate accepts it.
+  _Tp* allocate_at_least(size_type __n, size_type& __got)
+    { return simple_alloc<_Tp, _Alloc>::allocate_at_least(__n, __got); }
+  bool try_expand(pointer __p, size_type __old_n, size_type __new_n)
+    { return simple_alloc<_Tp, _Alloc>::try_expand(__p, __old_n, __new_n); }
+  _Tp* allocate_aligned(size_type __n, size_t __align)
+    { return simple_alloc<_Tp, _Alloc>::allocate_aligned(__n, __align); }
+  void deallocate_aligned(pointer __p, size_type __n, size_t __align)
+    { simple_alloc<_Tp, _Alloc>::deallocate_aligned(__p, __n, __align); }
 
   size_type max_size() const __STL_NOTHROW 
     { return size_t(-1) / sizeof(_Tp); }
@@ -712,14 +3420,30 @@ struct __allocator {
 
   // __n is permitted to be 0.
   _Tp* allocate(size_type __n, const void* = 0) {
-    return __n != 0 
+    _Tp* __result = __n != 0 
         ? static_cast<_Tp*>(__underlying_alloc.allocate(__n * sizeof(_Tp))) 
         : 0;
+    __STL_ALLOC_SAMPLE(
+      alloc_sampler::_S_note_allocate(__result, __n * sizeof(_Tp)));
+    return __result;
   }
 
   // __p is not permitted to be a null pointer.
-  void deallocate(pointer __p, size_type __n)
-    { __underlying_alloc.deallocate(__p, __n * sizeof(_Tp)); }
+  void deallocate(pointer __p, size_type __n) {
+    __STL_ALLOC_SAMPLE(alloc_sampler::_S_note_deallocate(__p));
+    __underlying_alloc.deallocate(__p, __n * sizeof(_Tp));
+  }
+
+  // Extensions; see _Alloc_extensions.  Unlike allocate and deallocate
+  // these go through _Alloc's static members, as simple_alloc does.
+  _Tp* allocate_at_least(size_type __n, size_type& __got)
+    { return simple_alloc<_Tp, _Alloc>::allocate_at_least(__n, __got); }
+  bool try_expand(pointer __p, size_type __old_n, size_type __new_n)
+    { return simple_alloc<_Tp, _Alloc>::try_expand(__p, __old_n, __new_n); }
+  _Tp* allocate_aligned(size_type __n, size_t __align)
+    { return simple_alloc<_Tp, _Alloc>::allocate_aligned(__n, __align); }
+  void deallocate_aligned(pointer __p, size_type __n, size_t __align)
+    { simple_alloc<_Tp, _Alloc>::deallocate_aligned(__p, __n, __align); }
 
   size_type max_size() const __STL_NOTHROW 
     { return size_t(-1) / sizeof(_Tp); }
@@ -861,6 +3585,18 @@ struct _Alloc_traits<_Tp, __default_alloc_template<__threads, __inst> >
           allocator_type;
 };
 
+#ifdef __STL_NODE_ALLOCATOR_SHARDED
+template <class _Tp, bool __threads, int __inst>
+struct _Alloc_traits<_Tp, __sharded_alloc_template<__threads, __inst> >
+{
+  static const bool _S_instanceless = true;
+  typedef simple_alloc<_Tp, __sharded_alloc_template<__threads, __inst> > 
+          _Alloc_type;
+  typedef __allocator<_Tp, __sharded_alloc_template<__threads, __inst> > 
+          allocator_type;
+};
+#endif /* __STL_NODE_ALLOCATOR_SHARDED */
+
 template <class _Tp, class _Alloc>
 struct _Alloc_traits<_Tp, debug_alloc<_Alloc> >
 {
@@ -893,6 +3629,20 @@ struct _Alloc_traits<_Tp,
           allocator_type;
 };
 
+#ifdef __STL_NODE_ALLOCATOR_SHARDED
+template <class _Tp, class _Tp1, bool __thr, int __inst>
+struct _Alloc_traits<_Tp, 
+                      __allocator<_Tp1, 
+                                  __sharded_alloc_template<__thr, __inst> > >
+{
+  static const bool _S_instanceless = true;
+  typedef simple_alloc<_Tp, __sharded_alloc_template<__thr,__inst> > 
+          _Alloc_type;
+  typedef __allocator<_Tp, __sharded_alloc_template<__thr,__inst> > 
+          allocator_type;
+};
+#endif /* __STL_NODE_ALLOCATOR_SHARDED */
+
 template <class _Tp, class _Tp1, class _Alloc>
 struct _Alloc_traits<_Tp, __allocator<_Tp1, debug_alloc<_Alloc> > >
 {
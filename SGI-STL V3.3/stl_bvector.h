@@ -554,6 +554,13 @@ public:
     copy(__x.begin(), __x.end(), _M_start);
   }
 
+  // A copy that allocates with __a; see _Construct_scoped.
+  __VECTOR(const __VECTOR& __x, const allocator_type& __a)
+    : __BVECTOR_BASE(__a) {
+    _M_initialize(__x.size());
+    copy(__x.begin(), __x.end(), _M_start);
+  }
+
 #ifdef __STL_MEMBER_TEMPLATES
 
   // Check whether it's an integral type.  If so, it's not an iterator.
@@ -87,6 +87,18 @@
 // * __STL_LONG_LONG if the compiler has long long and unsigned long long
 //   types.  (They're not in the C++ standard, but they are expected to be 
 //   included in the forthcoming C9X standard.)
+// * __STL_HAS_POSIX_MEMALIGN: defined if the C library provides
+//   posix_memalign, so that aligned blocks can be obtained from malloc
+//   and released with free.
+// * __STL_HAS_MMAP: defined if anonymous memory can be mapped with mmap
+//   and advised with madvise.
+// * __STL_HAS_MALLOC_USABLE_SIZE: defined if the C library provides
+//   malloc_usable_size.
+// * __STL_HAS_BACKTRACE: defined if the C library provides backtrace()
+//   in <execinfo.h>.
+// * __STL_HAS_DOUBLE_WIDTH_CAS: defined if the compiler can atomically
+//   compare-and-swap an object twice the size of a pointer, e.g. a
+//   pointer together with a counter.  On x86-64 g++ needs -mcx16.
 // * __STL_THREADS is defined if thread safety is needed.
 // * __STL_VOLATILE is defined to be "volatile" if threads are being
 //   used, and the empty string otherwise.
@@ -130,6 +142,98 @@
 //   standard-conforming iostreams (e.g. the <iosfwd> header).  If not
 //   defined, the STL will use old cfront-style iostreams (e.g. the
 //   <iostream.h> header).
+// * __STL_NODE_ALLOCATOR_THREAD_CACHE: if defined, then the default node
+//   allocator keeps a small per-thread cache of free objects for each
+//   size class, and takes its lock only when a cache is refilled or
+//   drained.  Requires pthreads; ignored otherwise.
+// * __STL_NODE_ALLOCATOR_TRIM: if defined, then the default node allocator
+//   carves its free lists out of fixed-size, aligned chunks whose headers
+//   count the objects handed out, and release_unused() returns chunks
+//   with no live objects to malloc.  __STL_NODE_ALLOCATOR_CHUNK_BYTES
+//   (a power of 2, default 64K) sets the chunk size.
+// * __STL_ALLOC_STATS: if defined, then malloc_alloc, debug_alloc and the
+//   default node allocator count their allocations, frees, refills,
+//   out-of-memory handler calls and pool growth, and each gains a static
+//   get_stats(stats_type&) member that copies out a snapshot.
+// * __STL_NODE_ALLOCATOR_LOCK_FREE: if defined, then the shared free
+//   lists of the default node allocator are updated with a single
+//   compare-and-swap instead of under a lock; only growing the pool
+//   still locks.  Needs __STL_HAS_DOUBLE_WIDTH_CAS, and is ignored
+//   without it.  Cannot be combined with __STL_NODE_ALLOCATOR_TRIM.
+// * __STL_NODE_ALLOCATOR_SHARDED: if defined, then alloc is split into
+//   __STL_NODE_ALLOCATOR_SHARDS (default 8) independent node allocators,
+//   each with its own free lists, pool and lock.  A thread allocates from
+//   the shard its id hashes to, and an object is freed back to the shard
+//   it came from.  The shards of an instance use the size classes and
+//   chunk source specialized for it.  Implies __STL_NODE_ALLOCATOR_TRIM.
+//   Needs pthreads, and is ignored without them.  Cannot be combined with
+//   __STL_NODE_ALLOCATOR_THREAD_CACHE or __STL_NODE_ALLOCATOR_LOCK_FREE.
+// * __STL_PTHREAD_ALLOC_NUMA: if defined, then on Linux pthread_alloc
+//   takes its memory in chunks bound to the NUMA node of the thread that
+//   carves them, keeps a reserve of __STL_PTHREAD_ALLOC_NODE_RESERVE
+//   (default 4) chunks per node, and sends blocks freed on another node
+//   back to the node that owns them.  __STL_PTHREAD_ALLOC_CHUNK_BYTES
+//   (a power of 2, default 256K) sets the chunk size, and
+//   __STL_PTHREAD_ALLOC_MAX_NODES (at most 64, default 8) the number of
+//   nodes told apart.
+// * __STL_USE_HUGE_PAGES: if defined, then the pool allocators take
+//   their chunks from _Huge_page_chunk_source, which maps memory in
+//   2 MiB aligned, huge-page advised blocks, instead of from malloc.
+//   The source can also be chosen per allocator instance by
+//   specializing __node_alloc_chunk_source,
+//   __pthread_alloc_chunk_source or __slab_alloc_chunk_source.
+// * __STL_PTHREAD_ALLOC_REMOTE_FREE: if defined, then a pthread_alloc
+//   block freed by a thread other than the one that allocated it is
+//   returned to the allocating thread, in batches of
+//   __STL_PTHREAD_ALLOC_REMOTE_BATCH (default 32), instead of joining
+//   the freeing thread's free lists.  Uses the same chunk settings as
+//   __STL_PTHREAD_ALLOC_NUMA, and may be combined with it.
+// * __STL_DEBUG_ALLOC_CHECKS: if defined, then debug_alloc surrounds
+//   each block with redzones of __STL_DEBUG_ALLOC_REDZONE bytes (a
+//   multiple of 8, default 16), fills fresh and freed memory with
+//   distinct patterns, holds freed blocks in a quarantine of
+//   __STL_DEBUG_ALLOC_QUARANTINE bytes (default 256K) to catch double
+//   frees and writes after free, and reports the blocks still live at
+//   exit by size class.  Errors abort, even with NDEBUG.
+// * __STL_DEBUG_ALLOC_GUARD_PAGES: if defined, then in addition each
+//   debug_alloc block is mapped on its own pages, ending against an
+//   inaccessible page, and freed blocks are made inaccessible.  Implies
+//   __STL_DEBUG_ALLOC_CHECKS.  Needs mmap, and is ignored without it.
+// * __STL_USE_DEBUG_ALLOC: if defined, then alloc and
+//   single_client_alloc, and so every container using the default
+//   allocator, go through debug_alloc.
+// * __STL_SLAB_ALLOC_SLAB_BYTES: the size of the slabs slab_alloc
+//   carves container nodes from (a power of 2, default 16K).
+// * __STL_ALLOC_SAMPLING: if defined, then alloc_sampler records the
+//   call stack of about one allocation in every
+//   __STL_ALLOC_SAMPLE_PERIOD bytes (default 512K; adjustable at run
+//   time) made by containers, and writes the samples still live and
+//   those taken so far, per call site, as a pprof heap profile.  Needs
+//   __STL_HAS_BACKTRACE, and pthreads if threads are used; ignored
+//   otherwise.
+// * __STL_ALLOC_TRACING: if defined, then alloc_tracer can record every
+//   request made of the node allocator (size, allocation or
+//   deallocation, thread) to a binary trace file, for replay against
+//   other size classes and chunk sizes.  Needs pthreads if threads are
+//   used; ignored otherwise.
+// * __STL_NO_FLAT_HASH_SIMD: if defined, then flat_hash_map and
+//   flat_hash_set compare their control bytes a machine word at a time
+//   even when the compiler targets SSE2.
+// * __STL_FLAT_HASH_AVX2: if defined, and the compiler targets AVX2,
+//   then flat_hash_map and flat_hash_set compare their control bytes 32
+//   at a time instead of 16.
+// * __STL_HASHTABLE_INCREMENTAL_REHASH: if defined, then a growing
+//   hashtable (hash_map, hash_set and the multi variants) keeps its old
+//   buckets alongside the new ones and moves a few buckets' worth of
+//   elements per insertion, instead of all of them at once, so that no
+//   single insertion pays for the whole rehash.  A range insertion that
+//   more than doubles the table moves them all at once.  Erasing moves
+//   nothing, so that it keeps the iteration order; the old buckets stay
+//   until later insertions or clear() empty them.
+// * __STL_HASHTABLE_CACHE_HASH: if defined, then each hashtable node
+//   also stores the hash code of its key, so that rehashing, erasing
+//   and iterating never call the hash function, and lookups compare
+//   hash codes before calling the key equality.  Costs a word per node.
 
 // Other macros defined by this file:
 
@@ -288,6 +392,18 @@
 #   ifdef _REENTRANT
 #     define __STL_PTHREADS
 #   endif
+#   if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__)
+#     define __STL_HAS_POSIX_MEMALIGN
+#     define __STL_HAS_MMAP
+#   endif
+#   ifdef __linux__
+#     define __STL_HAS_MALLOC_USABLE_SIZE
+#     define __STL_HAS_BACKTRACE
+#   endif
+#   if (defined(__LP64__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)) \
+      || (!defined(__LP64__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8))
+#     define __STL_HAS_DOUBLE_WIDTH_CAS
+#   endif
 #   if (__GNUC__ < 2) || (__GNUC__ == 2 && __GNUC_MINOR__ < 95)
 #     define __STL_NO_FUNCTION_PTR_IN_CLASS_TEMPLATE
 #   endif
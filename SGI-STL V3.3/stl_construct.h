@@ -58,6 +58,109 @@ inline void _Destroy(_Tp* __pointer) {
   __pointer->~_Tp();
 }
 
+// Scoped construction.  A container whose allocator has state hands it
+// on to the elements it copies in, when they are containers that can
+// allocate with it too, or pairs holding one.  A map of vectors built
+// on an arena then draws the vectors from the same arena.
+// _Uses_allocator<_Tp, _Alloc>::_Ret says whether _Tp takes __a; each
+// container answers for itself, in its own header, and has a
+// constructor _Tp(const _Tp&, const allocator_type&) for the purpose.
+// 作用域配置器: 外层容器把有状态的配置器传给它复制进来的内层容器
+
+template <class _Tp, class _Alloc>
+struct _Uses_allocator {
+  typedef __false_type _Ret;
+};
+
+template <class _T1, class _T2, class _Alloc>
+inline void _Construct_scoped(_T1* __p, const _T2& __value,
+                              const _Alloc& __a);
+
+template <class _T1, class _T2, class _Alloc>
+inline void __construct_scoped(_T1* __p, const _T2& __value,
+                               const _Alloc&, __false_type) {
+  _Construct(__p, __value);
+}
+
+template <class _T1, class _T2, class _Alloc>
+inline void __construct_scoped(_T1* __p, const _T2& __value,
+                               const _Alloc& __a, __true_type) {
+  new ((void*) __p) _T1(__value, __a);
+}
+
+#ifdef __STL_CLASS_PARTIAL_SPECIALIZATION
+
+template <class _Tp, class _Alloc>
+struct _Uses_allocator<const _Tp, _Alloc>
+  : public _Uses_allocator<_Tp, _Alloc> {};
+
+template <class _Ret1, class _Ret2>
+struct _Scoped_or {
+  typedef __true_type _Ret;
+};
+
+__STL_TEMPLATE_NULL struct _Scoped_or<__false_type, __false_type> {
+  typedef __false_type _Ret;
+};
+
+template <class _T1, class _T2, class _Alloc>
+struct _Uses_allocator<pair<_T1, _T2>, _Alloc> {
+  typedef typename _Scoped_or<typename _Uses_allocator<_T1, _Alloc>::_Ret,
+                              typename _Uses_allocator<_T2, _Alloc>::_Ret>
+          ::_Ret _Ret;
+};
+
+#ifdef __STL_FUNCTION_TMPL_PARTIAL_ORDER
+// pair has no constructor taking an allocator, so build it a member at
+// a time.
+template <class _T1, class _T2, class _U1, class _U2, class _Alloc>
+inline void __construct_scoped(pair<_T1, _T2>* __p,
+                               const pair<_U1, _U2>& __value,
+                               const _Alloc& __a, __true_type) {
+  _Construct_scoped(&__p->first, __value.first, __a);
+  __STL_TRY {
+    _Construct_scoped(&__p->second, __value.second, __a);
+  }
+  __STL_UNWIND(_Destroy(&__p->first));
+}
+#endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
+
+#ifdef __STL_USE_STD_ALLOCATORS
+
+template <class _Tp, class _Allocator> struct _Alloc_traits;
+
+template <class _Inner, class _Outer, bool _IsStatic>
+struct _Scoped_alloc_aux {
+  typedef __false_type _Ret;
+};
+
+template <class _Inner>
+struct _Scoped_alloc_aux<_Inner, _Inner, false> {
+  typedef __true_type _Ret;
+};
+
+// What a container of _Tp that allocates with _Inner answers: it takes
+// an _Outer that has state and rebinds to the same allocator_type.
+// Instanceless allocators are all alike, so there is nothing to pass.
+template <class _Tp, class _Inner, class _Outer>
+struct _Scoped_alloc_check
+  : public _Scoped_alloc_aux<
+      typename _Alloc_traits<_Tp, _Inner>::allocator_type,
+      typename _Alloc_traits<_Tp, _Outer>::allocator_type,
+      _Alloc_traits<_Tp, _Outer>::_S_instanceless> {};
+
+#endif /* __STL_USE_STD_ALLOCATORS */
+
+#endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */
+
+// Constructs a copy of __value at __p, giving it __a if it can use it.
+template <class _T1, class _T2, class _Alloc>
+inline void _Construct_scoped(_T1* __p, const _T2& __value,
+                              const _Alloc& __a) {
+  typedef typename _Uses_allocator<_T1, _Alloc>::_Ret _Scoped;
+  __construct_scoped(__p, __value, __a, _Scoped());
+}
+
 template <class _ForwardIterator>
 void
 __destroy_aux(_ForwardIterator __first, _ForwardIterator __last, __false_type)
@@ -529,7 +529,12 @@ public:                         // Constructor, destructor.
   explicit deque(const allocator_type& __a = allocator_type()) 
     : _Base(__a, 0) {}
   deque(const deque& __x) : _Base(__x.get_allocator(), __x.size()) 
-    { uninitialized_copy(__x.begin(), __x.end(), _M_start); }
+    { _Uninitialized_copy_scoped(__x.begin(), __x.end(), _M_start,
+                                 get_allocator()); }
+  // A copy that allocates with __a; see _Construct_scoped.
+  deque(const deque& __x, const allocator_type& __a) : _Base(__a, __x.size())
+    { _Uninitialized_copy_scoped(__x.begin(), __x.end(), _M_start,
+                                 get_allocator()); }
   deque(size_type __n, const value_type& __value,
         const allocator_type& __a = allocator_type()) : _Base(__a, __n)
     { _M_fill_initialize(__value); }
@@ -563,11 +568,11 @@ public:                         // Constructor, destructor.
   deque(const value_type* __first, const value_type* __last,
         const allocator_type& __a = allocator_type()) 
     : _Base(__a, __last - __first)
-    { uninitialized_copy(__first, __last, _M_start); }
+    { _Uninitialized_copy_scoped(__first, __last, _M_start, get_allocator()); }
   deque(const_iterator __first, const_iterator __last,
         const allocator_type& __a = allocator_type()) 
     : _Base(__a, __last - __first)
-    { uninitialized_copy(__first, __last, _M_start); }
+    { _Uninitialized_copy_scoped(__first, __last, _M_start, get_allocator()); }
 
 #endif /* __STL_MEMBER_TEMPLATES */
 
@@ -660,7 +665,7 @@ public:                         // push_* and pop_*
   
   void push_back(const value_type& __t) {
     if (_M_finish._M_cur != _M_finish._M_last - 1) {
-      construct(_M_finish._M_cur, __t);
+      _Construct_scoped(_M_finish._M_cur, __t, get_allocator());
       ++_M_finish._M_cur;
     }
     else
@@ -678,7 +683,7 @@ public:                         // push_* and pop_*
 
   void push_front(const value_type& __t) {
     if (_M_start._M_cur != _M_start._M_first) {
-      construct(_M_start._M_cur - 1, __t);
+      _Construct_scoped(_M_start._M_cur - 1, __t, get_allocator());
       --_M_start._M_cur;
     }
     else
@@ -925,7 +930,7 @@ void deque<_Tp, _Alloc>::_M_fill_insert(iterator __pos,
   if (__pos._M_cur == _M_start._M_cur) {
     iterator __new_start = _M_reserve_elements_at_front(__n);
     __STL_TRY {
-      uninitialized_fill(__new_start, _M_start, __x);
+      _Uninitialized_fill_scoped(__new_start, _M_start, __x, get_allocator());
       _M_start = __new_start;
     }
     __STL_UNWIND(_M_destroy_nodes(__new_start._M_node, _M_start._M_node));
@@ -933,7 +938,7 @@ void deque<_Tp, _Alloc>::_M_fill_insert(iterator __pos,
   else if (__pos._M_cur == _M_finish._M_cur) {
     iterator __new_finish = _M_reserve_elements_at_back(__n);
     __STL_TRY {
-      uninitialized_fill(_M_finish, __new_finish, __x);
+      _Uninitialized_fill_scoped(_M_finish, __new_finish, __x, get_allocator());
       _M_finish = __new_finish;
     }
     __STL_UNWIND(_M_destroy_nodes(_M_finish._M_node + 1, 
@@ -953,7 +958,7 @@ void deque<_Tp, _Alloc>::insert(iterator __pos,
   if (__pos._M_cur == _M_start._M_cur) {
     iterator __new_start = _M_reserve_elements_at_front(__n);
     __STL_TRY {
-      uninitialized_copy(__first, __last, __new_start);
+      _Uninitialized_copy_scoped(__first, __last, __new_start, get_allocator());
       _M_start = __new_start;
     }
     __STL_UNWIND(_M_destroy_nodes(__new_start._M_node, _M_start._M_node));
@@ -961,7 +966,7 @@ void deque<_Tp, _Alloc>::insert(iterator __pos,
   else if (__pos._M_cur == _M_finish._M_cur) {
     iterator __new_finish = _M_reserve_elements_at_back(__n);
     __STL_TRY {
-      uninitialized_copy(__first, __last, _M_finish);
+      _Uninitialized_copy_scoped(__first, __last, _M_finish, get_allocator());
       _M_finish = __new_finish;
     }
     __STL_UNWIND(_M_destroy_nodes(_M_finish._M_node + 1, 
@@ -979,7 +984,7 @@ void deque<_Tp,_Alloc>::insert(iterator __pos,
   if (__pos._M_cur == _M_start._M_cur) {
     iterator __new_start = _M_reserve_elements_at_front(__n);
     __STL_TRY {
-      uninitialized_copy(__first, __last, __new_start);
+      _Uninitialized_copy_scoped(__first, __last, __new_start, get_allocator());
       _M_start = __new_start;
     }
     __STL_UNWIND(_M_destroy_nodes(__new_start._M_node, _M_start._M_node));
@@ -987,7 +992,7 @@ void deque<_Tp,_Alloc>::insert(iterator __pos,
   else if (__pos._M_cur == _M_finish._M_cur) {
     iterator __new_finish = _M_reserve_elements_at_back(__n);
     __STL_TRY {
-      uninitialized_copy(__first, __last, _M_finish);
+      _Uninitialized_copy_scoped(__first, __last, _M_finish, get_allocator());
       _M_finish = __new_finish;
     }
     __STL_UNWIND(_M_destroy_nodes(_M_finish._M_node + 1, 
@@ -1056,8 +1061,10 @@ void deque<_Tp,_Alloc>::_M_fill_initialize(const value_type& __value) {
   _Map_pointer __cur;
   __STL_TRY {
     for (__cur = _M_start._M_node; __cur < _M_finish._M_node; ++__cur)
-      uninitialized_fill(*__cur, *__cur + _S_buffer_size(), __value);
-    uninitialized_fill(_M_finish._M_first, _M_finish._M_cur, __value);
+      _Uninitialized_fill_scoped(*__cur, *__cur + _S_buffer_size(), __value,
+                                 get_allocator());
+    _Uninitialized_fill_scoped(_M_finish._M_first, _M_finish._M_cur, __value,
+                               get_allocator());
   }
   __STL_UNWIND(destroy(_M_start, iterator(*__cur, __cur)));
 }
@@ -1093,10 +1100,11 @@ void deque<_Tp,_Alloc>::_M_range_initialize(_ForwardIterator __first,
          ++__cur_node) {
       _ForwardIterator __mid = __first;
       advance(__mid, _S_buffer_size());
-      uninitialized_copy(__first, __mid, *__cur_node);
+      _Uninitialized_copy_scoped(__first, __mid, *__cur_node, get_allocator());
       __first = __mid;
     }
-    uninitialized_copy(__first, __last, _M_finish._M_first);
+    _Uninitialized_copy_scoped(__first, __last, _M_finish._M_first,
+                               get_allocator());
   }
   __STL_UNWIND(destroy(_M_start, iterator(*__cur_node, __cur_node)));
 }
@@ -1111,7 +1119,7 @@ void deque<_Tp,_Alloc>::_M_push_back_aux(const value_type& __t)
   _M_reserve_map_at_back();
   *(_M_finish._M_node + 1) = _M_allocate_node();
   __STL_TRY {
-    construct(_M_finish._M_cur, __t_copy);
+    _Construct_scoped(_M_finish._M_cur, __t_copy, get_allocator());
     _M_finish._M_set_node(_M_finish._M_node + 1);
     _M_finish._M_cur = _M_finish._M_first;
   }
@@ -1142,7 +1150,7 @@ void  deque<_Tp,_Alloc>::_M_push_front_aux(const value_type& __t)
   __STL_TRY {
     _M_start._M_set_node(_M_start._M_node - 1);
     _M_start._M_cur = _M_start._M_last - 1;
-    construct(_M_start._M_cur, __t_copy);
+    _Construct_scoped(_M_start._M_cur, __t_copy, get_allocator());
   }
   __STL_UNWIND((++_M_start, _M_deallocate_node(*(_M_start._M_node - 1))));
 } 
@@ -1204,7 +1212,7 @@ deque<_Tp,_Alloc>::insert(iterator __pos,
   if (__pos._M_cur == _M_start._M_cur) {
     iterator __new_start = _M_reserve_elements_at_front(__n);
     __STL_TRY {
-      uninitialized_copy(__first, __last, __new_start);
+      _Uninitialized_copy_scoped(__first, __last, __new_start, get_allocator());
       _M_start = __new_start;
     }
     __STL_UNWIND(_M_destroy_nodes(__new_start._M_node, _M_start._M_node));
@@ -1212,7 +1220,7 @@ deque<_Tp,_Alloc>::insert(iterator __pos,
   else if (__pos._M_cur == _M_finish._M_cur) {
     iterator __new_finish = _M_reserve_elements_at_back(__n);
     __STL_TRY {
-      uninitialized_copy(__first, __last, _M_finish);
+      _Uninitialized_copy_scoped(__first, __last, _M_finish, get_allocator());
       _M_finish = __new_finish;
     }
     __STL_UNWIND(_M_destroy_nodes(_M_finish._M_node + 1, 
@@ -1298,14 +1306,15 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
     __STL_TRY {
       if (__elems_before >= difference_type(__n)) {
         iterator __start_n = _M_start + difference_type(__n);
-        uninitialized_copy(_M_start, __start_n, __new_start);
+        _Uninitialized_copy_scoped(_M_start, __start_n, __new_start,
+                                   get_allocator());
         _M_start = __new_start;
         copy(__start_n, __pos, __old_start);
         fill(__pos - difference_type(__n), __pos, __x_copy);
       }
       else {
         __uninitialized_copy_fill(_M_start, __pos, __new_start, 
-                                  _M_start, __x_copy);
+                                  _M_start, __x_copy, get_allocator());
         _M_start = __new_start;
         fill(__old_start, __pos, __x_copy);
       }
@@ -1321,14 +1330,15 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
     __STL_TRY {
       if (__elems_after > difference_type(__n)) {
         iterator __finish_n = _M_finish - difference_type(__n);
-        uninitialized_copy(__finish_n, _M_finish, _M_finish);
+        _Uninitialized_copy_scoped(__finish_n, _M_finish, _M_finish,
+                                   get_allocator());
         _M_finish = __new_finish;
         copy_backward(__pos, __finish_n, __old_finish);
         fill(__pos, __pos + difference_type(__n), __x_copy);
       }
       else {
         __uninitialized_fill_copy(_M_finish, __pos + difference_type(__n),
-                                  __x_copy, __pos, _M_finish);
+                                  __x_copy, __pos, _M_finish, get_allocator());
         _M_finish = __new_finish;
         fill(__pos, __old_finish, __x_copy);
       }
@@ -1355,7 +1365,8 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
     __STL_TRY {
       if (__elemsbefore >= difference_type(__n)) {
         iterator __start_n = _M_start + difference_type(__n); 
-        uninitialized_copy(_M_start, __start_n, __new_start);
+        _Uninitialized_copy_scoped(_M_start, __start_n, __new_start,
+                                   get_allocator());
         _M_start = __new_start;
         copy(__start_n, __pos, __old_start);
         copy(__first, __last, __pos - difference_type(__n));
@@ -1364,7 +1375,7 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
         _ForwardIterator __mid = __first;
         advance(__mid, difference_type(__n) - __elemsbefore);
         __uninitialized_copy_copy(_M_start, __pos, __first, __mid,
-                                  __new_start);
+                                  __new_start, get_allocator());
         _M_start = __new_start;
         copy(__mid, __last, __old_start);
       }
@@ -1380,7 +1391,8 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
     __STL_TRY {
       if (__elemsafter > difference_type(__n)) {
         iterator __finish_n = _M_finish - difference_type(__n);
-        uninitialized_copy(__finish_n, _M_finish, _M_finish);
+        _Uninitialized_copy_scoped(__finish_n, _M_finish, _M_finish,
+                                   get_allocator());
         _M_finish = __new_finish;
         copy_backward(__pos, __finish_n, __old_finish);
         copy(__first, __last, __pos);
@@ -1388,7 +1400,8 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
       else {
         _ForwardIterator __mid = __first;
         advance(__mid, __elemsafter);
-        __uninitialized_copy_copy(__mid, __last, __pos, _M_finish, _M_finish);
+        __uninitialized_copy_copy(__mid, __last, __pos, _M_finish, _M_finish,
+                                  get_allocator());
         _M_finish = __new_finish;
         copy(__first, __mid, __pos);
       }
@@ -1415,7 +1428,8 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
     __STL_TRY {
       if (__elemsbefore >= difference_type(__n)) {
         iterator __start_n = _M_start + difference_type(__n);
-        uninitialized_copy(_M_start, __start_n, __new_start);
+        _Uninitialized_copy_scoped(_M_start, __start_n, __new_start,
+                                   get_allocator());
         _M_start = __new_start;
         copy(__start_n, __pos, __old_start);
         copy(__first, __last, __pos - difference_type(__n));
@@ -1424,7 +1438,7 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
         const value_type* __mid = 
           __first + (difference_type(__n) - __elemsbefore);
         __uninitialized_copy_copy(_M_start, __pos, __first, __mid,
-                                  __new_start);
+                                  __new_start, get_allocator());
         _M_start = __new_start;
         copy(__mid, __last, __old_start);
       }
@@ -1440,14 +1454,16 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
     __STL_TRY {
       if (__elemsafter > difference_type(__n)) {
         iterator __finish_n = _M_finish - difference_type(__n);
-        uninitialized_copy(__finish_n, _M_finish, _M_finish);
+        _Uninitialized_copy_scoped(__finish_n, _M_finish, _M_finish,
+                                   get_allocator());
         _M_finish = __new_finish;
         copy_backward(__pos, __finish_n, __old_finish);
         copy(__first, __last, __pos);
       }
       else {
         const value_type* __mid = __first + __elemsafter;
-        __uninitialized_copy_copy(__mid, __last, __pos, _M_finish, _M_finish);
+        __uninitialized_copy_copy(__mid, __last, __pos, _M_finish, _M_finish,
+                                  get_allocator());
         _M_finish = __new_finish;
         copy(__first, __mid, __pos);
       }
@@ -1472,7 +1488,8 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
     __STL_TRY {
       if (__elemsbefore >= __n) {
         iterator __start_n = _M_start + __n;
-        uninitialized_copy(_M_start, __start_n, __new_start);
+        _Uninitialized_copy_scoped(_M_start, __start_n, __new_start,
+                                   get_allocator());
         _M_start = __new_start;
         copy(__start_n, __pos, __old_start);
         copy(__first, __last, __pos - difference_type(__n));
@@ -1480,7 +1497,7 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
       else {
         const_iterator __mid = __first + (__n - __elemsbefore);
         __uninitialized_copy_copy(_M_start, __pos, __first, __mid,
-                                  __new_start);
+                                  __new_start, get_allocator());
         _M_start = __new_start;
         copy(__mid, __last, __old_start);
       }
@@ -1495,14 +1512,16 @@ void deque<_Tp,_Alloc>::_M_insert_aux(iterator __pos,
     __STL_TRY {
       if (__elemsafter > __n) {
         iterator __finish_n = _M_finish - difference_type(__n);
-        uninitialized_copy(__finish_n, _M_finish, _M_finish);
+        _Uninitialized_copy_scoped(__finish_n, _M_finish, _M_finish,
+                                   get_allocator());
         _M_finish = __new_finish;
         copy_backward(__pos, __finish_n, __old_finish);
         copy(__first, __last, __pos);
       }
       else {
         const_iterator __mid = __first + __elemsafter;
-        __uninitialized_copy_copy(__mid, __last, __pos, _M_finish, _M_finish);
+        __uninitialized_copy_copy(__mid, __last, __pos, _M_finish, _M_finish,
+                                  get_allocator());
         _M_finish = __new_finish;
         copy(__first, __mid, __pos);
       }
@@ -1638,6 +1657,13 @@ inline void swap(deque<_Tp,_Alloc>& __x, deque<_Tp,_Alloc>& __y) {
 
 #endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
 
+#if defined(__STL_USE_STD_ALLOCATORS) && \
+    defined(__STL_CLASS_PARTIAL_SPECIALIZATION)
+template <class _Tp, class _Alloc, class _Outer>
+struct _Uses_allocator<deque<_Tp, _Alloc>, _Outer>
+  : public _Scoped_alloc_check<_Tp, _Alloc, _Outer> {};
+#endif
+
 #if defined(__sgi) && !defined(__GNUC__) && (_MIPS_SIM != _MIPS_SIM_ABI32)
 #pragma reset woff 1174
 #pragma reset woff 1375
@@ -0,0 +1,901 @@
+/*
+ * Copyright (c) 1996,1997
+ * Silicon Graphics Computer Systems, Inc.
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Silicon Graphics makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ *
+ * Copyright (c) 1994
+ * Hewlett-Packard Company
+ *
+ * Permission to use, copy, modify, distribute and sell this software
+ * and its documentation for any purpose is hereby granted without fee,
+ * provided that the above copyright notice appear in all copies and
+ * that both that copyright notice and this permission notice appear
+ * in supporting documentation.  Hewlett-Packard Company makes no
+ * representations about the suitability of this software for any
+ * purpose.  It is provided "as is" without express or implied warranty.
+ *
+ */
+
+/* NOTE: This is an internal header file, included by other STL headers.
+ *   You should not attempt to use it directly.
+ */
+
+#ifndef __SGI_STL_INTERNAL_FLAT_HASHTABLE_H
+#define __SGI_STL_INTERNAL_FLAT_HASHTABLE_H
+
+// Open-addressing hashtable, used to implement the flat hashed
+// associative containers flat_hash_set and flat_hash_map.
+//
+// hashtable keeps each element in a node of its own and chains the
+// nodes of a bucket together, so a lookup follows one pointer to the
+// bucket and one more per element it looks at.  Here the elements sit
+// in one array of slots.  Beside it is an array of control bytes, one
+// per slot, saying whether the slot is empty, deleted, or full, and for
+// a full slot holding seven bits of the element's hash code (its tag).
+// A lookup hashes the key once.  The rest of the hash code picks where
+// the probe starts, and the control bytes are then read a group at a
+// time: only slots whose tag matches are compared with _M_equals, and
+// the first group with an empty slot ends the search.  Most lookups
+// read one group of control bytes and one slot.
+// A group is 16 control bytes compared with SSE2 where the compiler
+// targets it, 32 with AVX2 under __STL_FLAT_HASH_AVX2, and otherwise a
+// machine word compared with integer arithmetic.
+// The capacity is always 2^k - 1, and the table grows when it would be
+// more than 7/8 full.  The control bytes are followed by a sentinel,
+// which stops iteration, and by a copy of the first _S_WIDTH - 1 bytes,
+// so that a group can be read at any position without wrapping.  This
+// is the layout of Google's SwissTable.
+// Unlike hashtable, an insertion may move every element: it invalidates
+// all iterators, pointers and references into the table.  An erasure
+// invalidates only those to the erased element.
+// 开放寻址哈希表: 元素直接放在槽数组里, 每个槽一个控制字节(空/已删除/哈希值的7位),
+// 查找时一次比较一组控制字节, 只有匹配的槽才调用 _M_equals
+
+#include <stl_algobase.h>
+#include <stl_alloc.h>
+#include <stl_construct.h>
+#include <stl_uninitialized.h>
+#include <stl_function.h>
+#include <stl_hash_fun.h>
+
+#if !defined(__STL_NO_FLAT_HASH_SIMD) && defined(__SSE2__)
+# if defined(__STL_FLAT_HASH_AVX2) && defined(__AVX2__)
+#   include <immintrin.h>
+#   define __STL_FLAT_GROUP_AVX2
+# else
+#   include <emmintrin.h>
+#   define __STL_FLAT_GROUP_SSE2
+# endif
+#endif
+
+__STL_BEGIN_NAMESPACE
+
+typedef signed char _Flat_ctrl;
+
+// Control byte values.  A full slot holds its tag, the low seven bits of
+// the element's mixed hash code, so every full byte is nonnegative.
+enum {
+  __stl_flat_empty = -128,        // 1000 0000
+  __stl_flat_deleted = -2,        // 1111 1110
+  __stl_flat_sentinel = -1        // 1111 1111
+};
+
+// A group of control bytes.  Each _M_match function answers a mask with
+// one bit set for every matching byte, to be walked with __m &= __m - 1.
+// _S_lowest gives the position of the lowest match, _S_leading the
+// number of bytes after the highest; __m must not be 0.
+
+#if defined(__STL_FLAT_GROUP_AVX2)
+
+// 32 control bytes, compared with one AVX2 instruction.
+struct _Flat_group {
+  typedef unsigned int _Mask;
+  enum {_S_WIDTH = 32};
+
+  __m256i _M_ctrl;
+
+  explicit _Flat_group(const _Flat_ctrl* __p)
+    : _M_ctrl(_mm256_loadu_si256((const __m256i*) __p)) {}
+
+  _Mask _M_match(_Flat_ctrl __tag) const {
+    return (_Mask) _mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(_mm256_set1_epi8(__tag), _M_ctrl));
+  }
+  _Mask _M_match_empty() const {
+    return (_Mask) _mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(_mm256_set1_epi8(__stl_flat_empty), _M_ctrl));
+  }
+  // Empty and deleted are the values less than the sentinel.
+  _Mask _M_match_empty_or_deleted() const {
+    return (_Mask) _mm256_movemask_epi8(
+      _mm256_cmpgt_epi8(_mm256_set1_epi8(__stl_flat_sentinel), _M_ctrl));
+  }
+
+  static int _S_lowest(_Mask __m) { return __builtin_ctz(__m); }
+  static int _S_leading(_Mask __m) { return __builtin_clz(__m); }
+};
+
+#elif defined(__STL_FLAT_GROUP_SSE2)
+
+// 16 control bytes, compared with one SSE2 instruction.
+struct _Flat_group {
+  typedef unsigned int _Mask;
+  enum {_S_WIDTH = 16};
+
+  __m128i _M_ctrl;
+
+  explicit _Flat_group(const _Flat_ctrl* __p)
+    : _M_ctrl(_mm_loadu_si128((const __m128i*) __p)) {}
+
+  _Mask _M_match(_Flat_ctrl __tag) const {
+    return (_Mask) _mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_set1_epi8(__tag), _M_ctrl));
+  }
+  _Mask _M_match_empty() const {
+    return (_Mask) _mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_set1_epi8(__stl_flat_empty), _M_ctrl));
+  }
+  // Empty and deleted are the values less than the sentinel.
+  _Mask _M_match_empty_or_deleted() const {
+    return (_Mask) _mm_movemask_epi8(
+      _mm_cmpgt_epi8(_mm_set1_epi8(__stl_flat_sentinel), _M_ctrl));
+  }
+
+  static int _S_lowest(_Mask __m) { return __builtin_ctz(__m); }
+  static int _S_leading(_Mask __m)
+    { return __builtin_clz(__m) - (32 - _S_WIDTH); }
+};
+
+#else
+
+// A machine word of control bytes, compared with integer arithmetic.
+// A mask has the high bit of every matching byte set.  _M_match may
+// also flag a full slot whose tag differs from __tag in its lowest bit;
+// the caller compares keys anyway.
+struct _Flat_group {
+  typedef unsigned long _Mask;
+  enum {_S_WIDTH = sizeof(unsigned long)};
+
+  unsigned long _M_ctrl;
+
+  static unsigned long _S_lsbs() { return ~0UL / 255; }   // 0x0101...01
+  static unsigned long _S_msbs() { return _S_lsbs() << 7; } // 0x8080...80
+
+  // Byte __i of the group is the low byte of _M_ctrl >> 8 * __i, in any
+  // byte order.
+  explicit _Flat_group(const _Flat_ctrl* __p) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&_M_ctrl, __p, sizeof(_M_ctrl));
+#else
+    _M_ctrl = 0;
+    for (int __i = 0; __i < (int) _S_WIDTH; ++__i)
+      _M_ctrl |= (unsigned long) (unsigned char) __p[__i] << (8 * __i);
+#endif
+  }
+
+  _Mask _M_match(_Flat_ctrl __tag) const {
+    unsigned long __x = _M_ctrl ^ (_S_lsbs() * (unsigned char) __tag);
+    return (__x - _S_lsbs()) & ~__x & _S_msbs();
+  }
+  // Empty is the only value with the high bit set and bit 1 clear.
+  _Mask _M_match_empty() const
+    { return _M_ctrl & ~(_M_ctrl << 6) & _S_msbs(); }
+  // Empty and deleted are the values with the high bit set and bit 0
+  // clear.
+  _Mask _M_match_empty_or_deleted() const
+    { return _M_ctrl & ~(_M_ctrl << 7) & _S_msbs(); }
+
+  static int _S_lowest(_Mask __m) {
+# ifdef __GNUC__
+    return __builtin_ctzl(__m) >> 3;
+# else
+    int __i = 0;
+    for ( ; 0 == (__m & 0x80); __m >>= 8) ++__i;
+    return __i;
+# endif
+  }
+  static int _S_leading(_Mask __m) {
+# ifdef __GNUC__
+    return __builtin_clzl(__m) >> 3;
+# else
+    int __i = 0;
+    for ( ; 0 == (__m >> (8 * _S_WIDTH - 1)); __m <<= 8) ++__i;
+    return __i;
+# endif
+  }
+};
+
+#endif /* __STL_FLAT_GROUP_AVX2 */
+
+// The control bytes of a table with no slots: a sentinel, so that
+// begin() == end(), then empty bytes, so that a lookup stops at once.
+// Tables share them until their first insertion and never write them.
+template <bool __dummy>
+struct _Flat_empty_group {
+  static _Flat_ctrl _S_ctrl[32];  // As wide as the widest group.
+};
+
+template <bool __dummy>
+_Flat_ctrl _Flat_empty_group<__dummy>::_S_ctrl[32] = {
+  __stl_flat_sentinel, __stl_flat_empty, __stl_flat_empty, __stl_flat_empty,
+  __stl_flat_empty, __stl_flat_empty, __stl_flat_empty, __stl_flat_empty,
+  __stl_flat_empty, __stl_flat_empty, __stl_flat_empty, __stl_flat_empty,
+  __stl_flat_empty, __stl_flat_empty, __stl_flat_empty, __stl_flat_empty,
+  __stl_flat_empty, __stl_flat_empty, __stl_flat_empty, __stl_flat_empty,
+  __stl_flat_empty, __stl_flat_empty, __stl_flat_empty, __stl_flat_empty,
+  __stl_flat_empty, __stl_flat_empty, __stl_flat_empty, __stl_flat_empty,
+  __stl_flat_empty, __stl_flat_empty, __stl_flat_empty, __stl_flat_empty
+};
+
+struct _Flat_hash_iterator_base {
+  _Flat_ctrl* _M_ctrl;
+
+  _Flat_hash_iterator_base(_Flat_ctrl* __c) : _M_ctrl(__c) {}
+  _Flat_hash_iterator_base() {}
+
+  bool operator==(const _Flat_hash_iterator_base& __x) const
+    { return _M_ctrl == __x._M_ctrl; }
+  bool operator!=(const _Flat_hash_iterator_base& __x) const
+    { return _M_ctrl != __x._M_ctrl; }
+};
+
+template <class _Val, class _Ref, class _Ptr>
+struct _Flat_hash_iterator : public _Flat_hash_iterator_base {
+  typedef _Flat_hash_iterator<_Val,_Val&,_Val*>             iterator;
+  typedef _Flat_hash_iterator<_Val,const _Val&,const _Val*> const_iterator;
+  typedef _Flat_hash_iterator<_Val,_Ref,_Ptr>               _Self;
+
+  typedef forward_iterator_tag iterator_category;
+  typedef _Val value_type;
+  typedef _Ptr pointer;
+  typedef _Ref reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+
+  _Val* _M_slot;
+
+  _Flat_hash_iterator(_Flat_ctrl* __c, _Val* __s)
+    : _Flat_hash_iterator_base(__c), _M_slot(__s) {}
+  _Flat_hash_iterator() {}
+  _Flat_hash_iterator(const iterator& __x)
+    : _Flat_hash_iterator_base(__x._M_ctrl), _M_slot(__x._M_slot) {}
+
+  reference operator*() const { return *_M_slot; }
+#ifndef __SGI_STL_NO_ARROW_OPERATOR
+  pointer operator->() const { return &(operator*()); }
+#endif /* __SGI_STL_NO_ARROW_OPERATOR */
+
+  _Self& operator++() {
+    ++_M_ctrl;
+    ++_M_slot;
+    _M_skip_empty();
+    return *this;
+  }
+  _Self operator++(int) {
+    _Self __tmp = *this;
+    ++*this;
+    return __tmp;
+  }
+
+  // Moves on to the next full slot, or to the sentinel.
+  void _M_skip_empty() {
+    while (*_M_ctrl < __stl_flat_sentinel) {
+      ++_M_ctrl;
+      ++_M_slot;
+    }
+  }
+};
+
+#ifndef __STL_CLASS_PARTIAL_SPECIALIZATION
+
+inline forward_iterator_tag
+iterator_category(const _Flat_hash_iterator_base&)
+{
+  return forward_iterator_tag();
+}
+
+template <class _Val, class _Ref, class _Ptr>
+inline _Val*
+value_type(const _Flat_hash_iterator<_Val, _Ref, _Ptr>&)
+{
+  return 0;
+}
+
+inline ptrdiff_t*
+distance_type(const _Flat_hash_iterator_base&)
+{
+  return 0;
+}
+
+#endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */
+
+template <class _Val, class _Key, class _HashFcn,
+          class _ExtractKey, class _EqualKey, class _Alloc = alloc>
+class _Flat_hashtable;
+
+template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
+bool operator==(const _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>& __ht1,
+                const _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>& __ht2);
+
+template <class _Val, class _Key, class _HashFcn,
+          class _ExtractKey, class _EqualKey, class _Alloc>
+class _Flat_hashtable {
+public:
+  typedef _Key key_type;
+  typedef _Val value_type;
+  typedef _HashFcn hasher;
+  typedef _EqualKey key_equal;
+
+  typedef size_t            size_type;
+  typedef ptrdiff_t         difference_type;
+  typedef value_type*       pointer;
+  typedef const value_type* const_pointer;
+  typedef value_type&       reference;
+  typedef const value_type& const_reference;
+
+  typedef _Flat_hash_iterator<_Val,_Val&,_Val*>             iterator;
+  typedef _Flat_hash_iterator<_Val,const _Val&,const _Val*> const_iterator;
+
+  hasher hash_funct() const { return _M_hash; }
+  key_equal key_eq() const { return _M_equals; }
+
+private:
+  enum {_S_WIDTH = _Flat_group::_S_WIDTH};
+  typedef _Flat_group::_Mask _Mask;
+
+  // The slots and the control bytes come from one block of _Val's: the
+  // slots first, then enough _Val's to hold the control bytes.
+  static size_type _S_block_size(size_type __cap) {
+    return __cap + (__cap + (size_type) _S_WIDTH + sizeof(_Val) - 1)
+                   / sizeof(_Val);
+  }
+
+#ifdef __STL_USE_STD_ALLOCATORS
+public:
+  typedef typename _Alloc_traits<_Val,_Alloc>::allocator_type allocator_type;
+  allocator_type get_allocator() const { return _M_slot_allocator; }
+private:
+  allocator_type _M_slot_allocator;
+  _Val* _M_get_block(size_type __cap)
+    { return _M_slot_allocator.allocate(_S_block_size(__cap)); }
+  void _M_put_block(_Val* __p, size_type __cap)
+    { _M_slot_allocator.deallocate(__p, _S_block_size(__cap)); }
+# define __FLAT_HASH_ALLOC_INIT(__a) _M_slot_allocator(__a),
+#else /* __STL_USE_STD_ALLOCATORS */
+public:
+  typedef _Alloc allocator_type;
+  allocator_type get_allocator() const { return allocator_type(); }
+private:
+  typedef simple_alloc<_Val, _Alloc> _M_slot_allocator_type;
+  _Val* _M_get_block(size_type __cap)
+    { return _M_slot_allocator_type::allocate(_S_block_size(__cap)); }
+  void _M_put_block(_Val* __p, size_type __cap)
+    { _M_slot_allocator_type::deallocate(__p, _S_block_size(__cap)); }
+# define __FLAT_HASH_ALLOC_INIT(__a)
+#endif /* __STL_USE_STD_ALLOCATORS */
+
+private:
+  hasher                _M_hash;
+  key_equal             _M_equals;
+  _ExtractKey           _M_get_key;
+  _Flat_ctrl*           _M_ctrl;
+  _Val*                 _M_slots;
+  size_type             _M_capacity;      // 0, or 2^k - 1
+  size_type             _M_num_elements;
+  size_type             _M_growth_left;   // Empty slots we may still fill.
+
+public:
+  _Flat_hashtable(size_type __n,
+                  const _HashFcn&    __hf,
+                  const _EqualKey&   __eql,
+                  const _ExtractKey& __ext,
+                  const allocator_type& __a = allocator_type())
+    : __FLAT_HASH_ALLOC_INIT(__a)
+      _M_hash(__hf),
+      _M_equals(__eql),
+      _M_get_key(__ext)
+  {
+    _M_initialize_empty();
+    resize(__n);
+  }
+
+  _Flat_hashtable(size_type __n,
+                  const _HashFcn&    __hf,
+                  const _EqualKey&   __eql,
+                  const allocator_type& __a = allocator_type())
+    : __FLAT_HASH_ALLOC_INIT(__a)
+      _M_hash(__hf),
+      _M_equals(__eql),
+      _M_get_key(_ExtractKey())
+  {
+    _M_initialize_empty();
+    resize(__n);
+  }
+
+  _Flat_hashtable(const _Flat_hashtable& __ht)
+    : __FLAT_HASH_ALLOC_INIT(__ht.get_allocator())
+      _M_hash(__ht._M_hash),
+      _M_equals(__ht._M_equals),
+      _M_get_key(__ht._M_get_key)
+  {
+    _M_initialize_empty();
+    __STL_TRY {
+      _M_copy_from(__ht);
+    }
+    __STL_UNWIND(_M_deallocate());
+  }
+
+  // A copy that allocates with __a; see _Construct_scoped.
+  _Flat_hashtable(const _Flat_hashtable& __ht, const allocator_type& __a)
+    : __FLAT_HASH_ALLOC_INIT(__a)
+      _M_hash(__ht._M_hash),
+      _M_equals(__ht._M_equals),
+      _M_get_key(__ht._M_get_key)
+  {
+    _M_initialize_empty();
+    __STL_TRY {
+      _M_copy_from(__ht);
+    }
+    __STL_UNWIND(_M_deallocate());
+  }
+
+#undef __FLAT_HASH_ALLOC_INIT
+
+  _Flat_hashtable& operator= (const _Flat_hashtable& __ht)
+  {
+    if (&__ht != this) {
+      clear();
+      _M_hash = __ht._M_hash;
+      _M_equals = __ht._M_equals;
+      _M_get_key = __ht._M_get_key;
+      _M_copy_from(__ht);
+    }
+    return *this;
+  }
+
+  ~_Flat_hashtable() { _M_deallocate(); }
+
+  size_type size() const { return _M_num_elements; }
+  size_type max_size() const { return size_type(-1) / sizeof(_Val) / 2; }
+  bool empty() const { return size() == 0; }
+
+  void swap(_Flat_hashtable& __ht)
+  {
+    __STD::swap(_M_hash, __ht._M_hash);
+    __STD::swap(_M_equals, __ht._M_equals);
+    __STD::swap(_M_get_key, __ht._M_get_key);
+    __STD::swap(_M_ctrl, __ht._M_ctrl);
+    __STD::swap(_M_slots, __ht._M_slots);
+    __STD::swap(_M_capacity, __ht._M_capacity);
+    __STD::swap(_M_num_elements, __ht._M_num_elements);
+    __STD::swap(_M_growth_left, __ht._M_growth_left);
+  }
+
+  iterator begin()
+  {
+    iterator __it(_M_ctrl, _M_slots);
+    __it._M_skip_empty();
+    return __it;
+  }
+
+  iterator end() { return iterator(_M_ctrl + _M_capacity, 0); }
+
+  const_iterator begin() const
+  {
+    const_iterator __it(_M_ctrl, _M_slots);
+    __it._M_skip_empty();
+    return __it;
+  }
+
+  const_iterator end() const
+    { return const_iterator(_M_ctrl + _M_capacity, 0); }
+
+#ifdef __STL_MEMBER_TEMPLATES
+  template <class _Vl, class _Ky, class _HF, class _Ex, class _Eq, class _Al>
+  friend bool operator== (const _Flat_hashtable<_Vl,_Ky,_HF,_Ex,_Eq,_Al>&,
+                          const _Flat_hashtable<_Vl,_Ky,_HF,_Ex,_Eq,_Al>&);
+#else /* __STL_MEMBER_TEMPLATES */
+  friend bool __STD_QUALIFIER
+  operator== __STL_NULL_TMPL_ARGS (const _Flat_hashtable&,
+                                   const _Flat_hashtable&);
+#endif /* __STL_MEMBER_TEMPLATES */
+
+public:
+
+  // The number of slots.
+  size_type bucket_count() const { return _M_capacity; }
+
+  size_type max_bucket_count() const
+    { return (size_type(-1) >> 1) / sizeof(_Val); }
+
+  pair<iterator, bool> insert_unique(const value_type& __obj)
+  {
+    const size_type __h = _M_hash_of(_M_get_key(__obj));
+    size_type __i = _M_find(_M_get_key(__obj), __h);
+    if (__i != _M_capacity)
+      return pair<iterator, bool>(_M_iterator_at(__i), false);
+    __i = _M_prepare_insert(__h);
+    _M_construct_at(__i, __h, __obj);
+    return pair<iterator, bool>(_M_iterator_at(__i), true);
+  }
+
+#ifdef __STL_MEMBER_TEMPLATES
+  template <class _InputIterator>
+  void insert_unique(_InputIterator __f, _InputIterator __l)
+  {
+    insert_unique(__f, __l, __ITERATOR_CATEGORY(__f));
+  }
+
+  template <class _InputIterator>
+  void insert_unique(_InputIterator __f, _InputIterator __l,
+                     input_iterator_tag)
+  {
+    for ( ; __f != __l; ++__f)
+      insert_unique(*__f);
+  }
+
+  template <class _ForwardIterator>
+  void insert_unique(_ForwardIterator __f, _ForwardIterator __l,
+                     forward_iterator_tag)
+  {
+    size_type __n = 0;
+    distance(__f, __l, __n);
+    resize(_M_num_elements + __n);
+    for ( ; __n > 0; --__n, ++__f)
+      insert_unique(*__f);
+  }
+
+#else /* __STL_MEMBER_TEMPLATES */
+  void insert_unique(const value_type* __f, const value_type* __l)
+  {
+    size_type __n = __l - __f;
+    resize(_M_num_elements + __n);
+    for ( ; __n > 0; --__n, ++__f)
+      insert_unique(*__f);
+  }
+
+  void insert_unique(const_iterator __f, const_iterator __l)
+  {
+    size_type __n = 0;
+    distance(__f, __l, __n);
+    resize(_M_num_elements + __n);
+    for ( ; __n > 0; --__n, ++__f)
+      insert_unique(*__f);
+  }
+#endif /*__STL_MEMBER_TEMPLATES */
+
+  reference find_or_insert(const value_type& __obj)
+    { return *insert_unique(__obj).first; }
+
+  iterator find(const key_type& __key)
+    { return _M_iterator_at(_M_find(__key, _M_hash_of(__key))); }
+
+  const_iterator find(const key_type& __key) const
+    { return _M_iterator_at(_M_find(__key, _M_hash_of(__key))); }
+
+  size_type count(const key_type& __key) const
+    { return _M_find(__key, _M_hash_of(__key)) != _M_capacity ? 1 : 0; }
+
+  pair<iterator, iterator> equal_range(const key_type& __key)
+  {
+    iterator __first = find(__key);
+    iterator __last = __first;
+    if (__last != end())
+      ++__last;
+    return pair<iterator, iterator>(__first, __last);
+  }
+
+  pair<const_iterator, const_iterator> equal_range(const key_type& __key) const
+  {
+    const_iterator __first = find(__key);
+    const_iterator __last = __first;
+    if (__last != end())
+      ++__last;
+    return pair<const_iterator, const_iterator>(__first, __last);
+  }
+
+  size_type erase(const key_type& __key)
+  {
+    size_type __i = _M_find(__key, _M_hash_of(__key));
+    if (__i == _M_capacity)
+      return 0;
+    _M_erase_at(__i);
+    return 1;
+  }
+
+  void erase(const iterator& __it)
+    { _M_erase_at(__it._M_ctrl - _M_ctrl); }
+  void erase(iterator __first, iterator __last)
+  {
+    while (__first != __last)
+      erase(__first++);
+  }
+
+  void erase(const const_iterator& __it)
+    { _M_erase_at(__it._M_ctrl - _M_ctrl); }
+  void erase(const_iterator __first, const_iterator __last)
+  {
+    while (__first != __last)
+      erase(__first++);
+  }
+
+  // Makes room for __num_elements_hint elements without growing again.
+  // The table never shrinks.
+  void resize(size_type __num_elements_hint);
+  void clear();
+
+private:
+  size_type _M_hash_of(const key_type& __key) const
+    { return __stl_hash_mix(_M_hash(__key)); }
+  static _Flat_ctrl _S_tag(size_type __h)
+    { return (_Flat_ctrl) (__h & 0x7f); }
+
+  // At most 7/8 of the slots are filled, and always at least one is
+  // left empty, which ends every unsuccessful search.
+  static size_type _S_growth(size_type __cap)
+    { return __cap - __cap / 8 - 1; }
+
+  // The smallest capacity that holds __n elements.
+  static size_type _S_capacity_for(size_type __n) {
+    size_type __cap = 3;
+    while (_S_growth(__cap) < __n)
+      __cap = 2 * __cap + 1;
+    return __cap;
+  }
+
+  iterator _M_iterator_at(size_type __i)
+    { return iterator(_M_ctrl + __i, _M_slots + __i); }
+  const_iterator _M_iterator_at(size_type __i) const
+    { return const_iterator(_M_ctrl + __i, _M_slots + __i); }
+
+  void _M_initialize_empty()
+  {
+    _M_ctrl = _Flat_empty_group<true>::_S_ctrl;
+    _M_slots = 0;
+    _M_capacity = 0;
+    _M_num_elements = 0;
+    _M_growth_left = 0;
+  }
+
+  // Sets the control byte of slot __i, and its copy past the sentinel.
+  static void _S_set_ctrl(_Flat_ctrl* __ctrl, size_type __cap,
+                          size_type __i, _Flat_ctrl __c)
+  {
+    __ctrl[__i] = __c;
+    __ctrl[((__i - ((size_type) _S_WIDTH - 1)) & __cap)
+           + (((size_type) _S_WIDTH - 1) & __cap)] = __c;
+  }
+
+  // The probe sequence visits groups at offsets h, h + W, h + 3W,
+  // h + 6W, ... (mod capacity + 1), which reaches every group.
+
+  // The slot holding __key, or _M_capacity.
+  size_type _M_find(const key_type& __key, size_type __h) const
+  {
+    const _Flat_ctrl __tag = _S_tag(__h);
+    size_type __offset = (__h >> 7) & _M_capacity;
+    size_type __step = 0;
+    for (;;) {
+      _Flat_group __g(_M_ctrl + __offset);
+      for (_Mask __m = __g._M_match(__tag); __m != 0; __m &= __m - 1) {
+        size_type __i = (__offset + _Flat_group::_S_lowest(__m)) & _M_capacity;
+        if (_M_equals(_M_get_key(_M_slots[__i]), __key))
+          return __i;
+      }
+      if (__g._M_match_empty() != 0)
+        return _M_capacity;
+      __step += (size_type) _S_WIDTH;
+      __offset = (__offset + __step) & _M_capacity;
+    }
+  }
+
+  // The first empty or deleted slot on the probe sequence of __h.
+  static size_type _S_find_first_non_full(const _Flat_ctrl* __ctrl,
+                                          size_type __cap, size_type __h)
+  {
+    size_type __offset = (__h >> 7) & __cap;
+    size_type __step = 0;
+    for (;;) {
+      _Mask __m = _Flat_group(__ctrl + __offset)._M_match_empty_or_deleted();
+      if (__m != 0)
+        return (__offset + _Flat_group::_S_lowest(__m)) & __cap;
+      __step += (size_type) _S_WIDTH;
+      __offset = (__offset + __step) & __cap;
+    }
+  }
+
+  // The slot a new element with hash code __h goes in, growing the
+  // table first if it has no room.  A deleted slot can be reused at
+  // any time.
+  size_type _M_prepare_insert(size_type __h)
+  {
+    size_type __i = _S_find_first_non_full(_M_ctrl, _M_capacity, __h);
+    if (0 == _M_growth_left && __stl_flat_deleted != _M_ctrl[__i]) {
+      _M_rehash_and_grow();
+      __i = _S_find_first_non_full(_M_ctrl, _M_capacity, __h);
+    }
+    return __i;
+  }
+
+  // Constructs __obj in the unused slot __i.  Nothing changes if the
+  // construction throws.
+  void _M_construct_at(size_type __i, size_type __h, const value_type& __obj)
+  {
+    _Construct_scoped(_M_slots + __i, __obj, get_allocator());
+    if (__stl_flat_empty == _M_ctrl[__i])
+      --_M_growth_left;
+    _S_set_ctrl(_M_ctrl, _M_capacity, __i, _S_tag(__h));
+    ++_M_num_elements;
+  }
+
+  void _M_erase_at(size_type __i);
+
+  // With many deleted slots, cleans them out at the same capacity;
+  // otherwise doubles the capacity.
+  void _M_rehash_and_grow()
+  {
+    if (_M_capacity > 0 && _M_num_elements <= _S_growth(_M_capacity) / 2)
+      _M_rehash(_M_capacity);
+    else
+      _M_rehash(0 == _M_capacity ? 3 : 2 * _M_capacity + 1);
+  }
+
+  void _M_rehash(size_type __new_cap);
+  void _M_copy_from(const _Flat_hashtable& __ht);
+  // Destroys the elements and gives back the slots.
+  void _M_deallocate();
+
+};
+
+template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
+bool operator==(const _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>& __ht1,
+                const _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>& __ht2)
+{
+  typedef typename _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::const_iterator
+          _Const_iterator;
+  if (__ht1._M_num_elements != __ht2._M_num_elements)
+    return false;
+  for (_Const_iterator __it = __ht1.begin(); __it != __ht1.end(); ++__it) {
+    _Const_iterator __other = __ht2.find(__ht1._M_get_key(*__it));
+    if (__other == __ht2.end() || !(*__other == *__it))
+      return false;
+  }
+  return true;
+}
+
+#ifdef __STL_FUNCTION_TMPL_PARTIAL_ORDER
+
+template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
+inline bool
+operator!=(const _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>& __ht1,
+           const _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>& __ht2) {
+  return !(__ht1 == __ht2);
+}
+
+template <class _Val, class _Key, class _HF, class _Extract, class _EqKey,
+          class _All>
+inline void
+swap(_Flat_hashtable<_Val, _Key, _HF, _Extract, _EqKey, _All>& __ht1,
+     _Flat_hashtable<_Val, _Key, _HF, _Extract, _EqKey, _All>& __ht2) {
+  __ht1.swap(__ht2);
+}
+
+#endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
+
+template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
+void _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::_M_erase_at(size_type __i)
+{
+  destroy(_M_slots + __i);
+  --_M_num_elements;
+  // If no group read across slot __i was ever full, no probe went past
+  // it, and it can be empty again; otherwise searches must be told to
+  // go on.
+  size_type __before = (__i - (size_type) _S_WIDTH) & _M_capacity;
+  _Mask __empty_after = _Flat_group(_M_ctrl + __i)._M_match_empty();
+  _Mask __empty_before = _Flat_group(_M_ctrl + __before)._M_match_empty();
+  if (__empty_before != 0 && __empty_after != 0 &&
+      _Flat_group::_S_lowest(__empty_after)
+        + _Flat_group::_S_leading(__empty_before) < (int) _S_WIDTH) {
+    _S_set_ctrl(_M_ctrl, _M_capacity, __i, __stl_flat_empty);
+    ++_M_growth_left;
+  } else
+    _S_set_ctrl(_M_ctrl, _M_capacity, __i, __stl_flat_deleted);
+}
+
+template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
+void _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
+  ::resize(size_type __num_elements_hint)
+{
+  if (__num_elements_hint > _M_num_elements + _M_growth_left)
+    _M_rehash(_S_capacity_for(__num_elements_hint));
+}
+
+template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
+void _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::_M_rehash(size_type __cap)
+{
+  _Val* __slots = _M_get_block(__cap);
+  _Flat_ctrl* __ctrl = (_Flat_ctrl*) (__slots + __cap);
+  size_type __i;
+  uninitialized_fill_n(__ctrl, __cap + (size_type) _S_WIDTH,
+                       (_Flat_ctrl) __stl_flat_empty);
+  __ctrl[__cap] = __stl_flat_sentinel;
+
+  // Copies everything over before touching the old slots, so that the
+  // table is unchanged if a copy throws.
+  __STL_TRY {
+    for (__i = 0; __i < _M_capacity; ++__i)
+      if (_M_ctrl[__i] >= 0) {
+        size_type __h = _M_hash_of(_M_get_key(_M_slots[__i]));
+        size_type __j = _S_find_first_non_full(__ctrl, __cap, __h);
+        _Construct_scoped(__slots + __j, _M_slots[__i], get_allocator());
+        _S_set_ctrl(__ctrl, __cap, __j, _S_tag(__h));
+      }
+  }
+  __STL_UNWIND(for (__i = 0; __i < __cap; ++__i)
+                 if (__ctrl[__i] >= 0) destroy(__slots + __i);
+               _M_put_block(__slots, __cap));
+
+  size_type __num_elements = _M_num_elements;
+  _M_deallocate();
+  _M_ctrl = __ctrl;
+  _M_slots = __slots;
+  _M_capacity = __cap;
+  _M_num_elements = __num_elements;
+  _M_growth_left = _S_growth(__cap) - __num_elements;
+}
+
+template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
+void _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
+  ::_M_copy_from(const _Flat_hashtable& __ht)
+{
+  resize(__ht._M_num_elements);
+  for (size_type __i = 0; __i < __ht._M_capacity; ++__i)
+    if (__ht._M_ctrl[__i] >= 0) {
+      size_type __h = _M_hash_of(_M_get_key(__ht._M_slots[__i]));
+      _M_construct_at(_S_find_first_non_full(_M_ctrl, _M_capacity, __h),
+                      __h, __ht._M_slots[__i]);
+    }
+}
+
+template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
+void _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::clear()
+{
+  if (0 == _M_capacity)
+    return;
+  for (size_type __i = 0; __i < _M_capacity; ++__i)
+    if (_M_ctrl[__i] >= 0)
+      destroy(_M_slots + __i);
+  fill_n(_M_ctrl, _M_capacity + (size_type) _S_WIDTH,
+         (_Flat_ctrl) __stl_flat_empty);
+  _M_ctrl[_M_capacity] = __stl_flat_sentinel;
+  _M_num_elements = 0;
+  _M_growth_left = _S_growth(_M_capacity);
+}
+
+template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
+void _Flat_hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::_M_deallocate()
+{
+  if (0 == _M_capacity)
+    return;
+  for (size_type __i = 0; __i < _M_capacity; ++__i)
+    if (_M_ctrl[__i] >= 0)
+      destroy(_M_slots + __i);
+  _M_put_block(_M_slots, _M_capacity);
+  _M_initialize_empty();
+}
+
+__STL_END_NAMESPACE
+
+#endif /* __SGI_STL_INTERNAL_FLAT_HASHTABLE_H */
+
+// Local Variables:
+// mode:C++
+// End:
@@ -84,6 +84,34 @@ __STL_TEMPLATE_NULL struct hash<unsigned long> {
   size_t operator()(unsigned long __x) const { return __x; }
 };
 
+// Spreads the bits of a hash code over the whole word.  The hashes
+// above are the identity on integers, which is harmless modulo a prime,
+// but a table that takes its position from some of the bits would put
+// sequential keys side by side and keys that differ only in their high
+// bits all in one place.  Multiplying by 2^w / phi (Fibonacci hashing)
+// carries every bit of the code up into the high half of the product,
+// and folding the halves together brings them back down.
+// 打散哈希值: 乘黄金分割常数, 再把高半部分折叠到低半部分
+inline size_t __stl_hash_mix(size_t __h)
+{
+  const size_t __golden = sizeof(size_t) > 4
+    ? ((((size_t) 0x9e3779b9u << 16) << 16) | (size_t) 0x7f4a7c15u)
+    : (size_t) 0x9e3779b9u;
+  __h *= __golden;
+  return __h ^ (__h >> (sizeof(size_t) * 4));
+}
+
+// The hash function _HashFcn, asking the hashed containers for
+// power-of-two bucket counts: hash_map<int, int, mask_hash<hash<int> > >
+// finds its buckets with a mask instead of a division by a prime.  Works
+// only where the compiler supports partial specialization; elsewhere
+// it is just _HashFcn.
+template <class _HashFcn>
+struct mask_hash : public _HashFcn {
+  mask_hash() {}
+  mask_hash(const _HashFcn& __hf) : _HashFcn(__hf) {}
+};
+
 __STL_END_NAMESPACE
 
 #endif /* __SGI_STL_HASH_FUN_H */
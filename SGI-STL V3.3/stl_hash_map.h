@@ -101,6 +101,9 @@ public:
   hash_map(size_type __n, const hasher& __hf, const key_equal& __eql,
            const allocator_type& __a = allocator_type())
     : _M_ht(__n, __hf, __eql, __a) {}
+  // A copy that allocates with __a; see _Construct_scoped.
+  hash_map(const hash_map& __x, const allocator_type& __a)
+    : _M_ht(__x._M_ht, __a) {}
 
 #ifdef __STL_MEMBER_TEMPLATES
   template <class _InputIterator>
@@ -250,6 +253,14 @@ swap(hash_map<_Key,_Tp,_HashFcn,_EqlKey,_Alloc>& __hm1,
 
 #endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
 
+#if defined(__STL_USE_STD_ALLOCATORS) && \
+    defined(__STL_CLASS_PARTIAL_SPECIALIZATION)
+template <class _Key, class _Tp, class _HashFcn, class _EqlKey, class _Alloc,
+          class _Outer>
+struct _Uses_allocator<hash_map<_Key,_Tp,_HashFcn,_EqlKey,_Alloc>, _Outer>
+  : public _Scoped_alloc_check<pair<const _Key, _Tp>, _Alloc, _Outer> {};
+#endif
+
 // Forward declaration of equality operator; needed for friend declaration.
 
 template <class _Key, class _Tp,
@@ -313,6 +324,9 @@ public:
   hash_multimap(size_type __n, const hasher& __hf, const key_equal& __eql,
                 const allocator_type& __a = allocator_type())
     : _M_ht(__n, __hf, __eql, __a) {}
+  // A copy that allocates with __a; see _Construct_scoped.
+  hash_multimap(const hash_multimap& __x, const allocator_type& __a)
+    : _M_ht(__x._M_ht, __a) {}
 
 #ifdef __STL_MEMBER_TEMPLATES
   template <class _InputIterator>
@@ -458,6 +472,15 @@ swap(hash_multimap<_Key,_Tp,_HashFcn,_EqlKey,_Alloc>& __hm1,
 
 #endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
 
+#if defined(__STL_USE_STD_ALLOCATORS) && \
+    defined(__STL_CLASS_PARTIAL_SPECIALIZATION)
+template <class _Key, class _Tp, class _HashFcn, class _EqlKey, class _Alloc,
+          class _Outer>
+struct _Uses_allocator<hash_multimap<_Key,_Tp,_HashFcn,_EqlKey,_Alloc>,
+                       _Outer>
+  : public _Scoped_alloc_check<pair<const _Key, _Tp>, _Alloc, _Outer> {};
+#endif
+
 // Specialization of insert_iterator so that it will work for hash_map
 // and hash_multimap.
 
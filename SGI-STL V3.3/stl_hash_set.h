@@ -99,6 +99,9 @@ public:
   hash_set(size_type __n, const hasher& __hf, const key_equal& __eql,
            const allocator_type& __a = allocator_type())
     : _M_ht(__n, __hf, __eql, __a) {}
+  // A copy that allocates with __a; see _Construct_scoped.
+  hash_set(const hash_set& __x, const allocator_type& __a)
+    : _M_ht(__x._M_ht, __a) {}
 
 #ifdef __STL_MEMBER_TEMPLATES
   template <class _InputIterator>
@@ -244,6 +247,14 @@ swap(hash_set<_Val,_HashFcn,_EqualKey,_Alloc>& __hs1,
 
 #endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
 
+#if defined(__STL_USE_STD_ALLOCATORS) && \
+    defined(__STL_CLASS_PARTIAL_SPECIALIZATION)
+template <class _Val, class _HashFcn, class _EqualKey, class _Alloc,
+          class _Outer>
+struct _Uses_allocator<hash_set<_Val,_HashFcn,_EqualKey,_Alloc>, _Outer>
+  : public _Scoped_alloc_check<_Val, _Alloc, _Outer> {};
+#endif
+
 
 template <class _Value,
           class _HashFcn  __STL_DEPENDENT_DEFAULT_TMPL(hash<_Value>),
@@ -303,6 +314,9 @@ public:
   hash_multiset(size_type __n, const hasher& __hf, const key_equal& __eql,
                 const allocator_type& __a = allocator_type())
     : _M_ht(__n, __hf, __eql, __a) {}
+  // A copy that allocates with __a; see _Construct_scoped.
+  hash_multiset(const hash_multiset& __x, const allocator_type& __a)
+    : _M_ht(__x._M_ht, __a) {}
 
 #ifdef __STL_MEMBER_TEMPLATES
   template <class _InputIterator>
@@ -440,6 +454,14 @@ swap(hash_multiset<_Val,_HashFcn,_EqualKey,_Alloc>& __hs1,
 
 #endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
 
+#if defined(__STL_USE_STD_ALLOCATORS) && \
+    defined(__STL_CLASS_PARTIAL_SPECIALIZATION)
+template <class _Val, class _HashFcn, class _EqualKey, class _Alloc,
+          class _Outer>
+struct _Uses_allocator<hash_multiset<_Val,_HashFcn,_EqualKey,_Alloc>, _Outer>
+  : public _Scoped_alloc_check<_Val, _Alloc, _Outer> {};
+#endif
+
 // Specialization of insert_iterator so that it will work for hash_set
 // and hash_multiset.
 
@@ -50,6 +50,9 @@ template <class _Val>
 struct _Hashtable_node
 {
   _Hashtable_node* _M_next;
+#ifdef __STL_HASHTABLE_CACHE_HASH
+  size_t _M_hash_code;            // _M_hash of the key, never recomputed.
+#endif /* __STL_HASHTABLE_CACHE_HASH */
   _Val _M_val;
 };  
 
@@ -165,6 +168,52 @@ inline unsigned long __stl_next_prime(unsigned long __n)
   return pos == __last ? *(__last - 1) : *pos;
 }
 
+// How a hashtable sizes its bucket vector and picks a bucket for a hash
+// code.  The default takes the code modulo a prime.  A hash function
+// wrapped in mask_hash selects power-of-two sizes instead: the code is
+// mixed, since the mask keeps only its low bits, and then masked, which
+// saves the division.
+// 桶策略: 默认用质数取模; 哈希函数包在 mask_hash 里时用2的幂, 打散后取掩码
+
+struct _Hashtable_prime_policy {
+  static size_t _S_next_size(size_t __n)
+    { return __stl_next_prime(__n); }
+  static size_t _S_max_size()
+    { return __stl_prime_list[(int)__stl_num_primes - 1]; }
+  static size_t _S_index(size_t __h, size_t __n)
+    { return __h % __n; }
+};
+
+struct _Hashtable_mask_policy {
+  static size_t _S_next_size(size_t __n) {
+    size_t __size = 64;
+    while (__size < __n && __size < _S_max_size())
+      __size <<= 1;
+    return __size;
+  }
+  static size_t _S_max_size()
+    { return (size_t) 1 << (sizeof(size_t) * 8 - 1); }
+  static size_t _S_index(size_t __h, size_t __n)
+    { return __stl_hash_mix(__h) & (__n - 1); }
+};
+
+template <class _HashFcn>
+struct _Hashtable_bucket_policy {
+  typedef _Hashtable_prime_policy _Policy;
+};
+
+#ifdef __STL_CLASS_PARTIAL_SPECIALIZATION
+template <class _HashFcn>
+struct _Hashtable_bucket_policy<mask_hash<_HashFcn> > {
+  typedef _Hashtable_mask_policy _Policy;
+};
+#endif /* __STL_CLASS_PARTIAL_SPECIALIZATION */
+
+#ifdef __STL_HASHTABLE_INCREMENTAL_REHASH
+// The number of old buckets a growing hashtable empties per insertion.
+enum { __stl_rehash_step = 4 };
+#endif /* __STL_HASHTABLE_INCREMENTAL_REHASH */
+
 // Forward declaration of operator==.
 
 template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
@@ -183,6 +232,32 @@ bool operator==(const hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>& __ht1,
 //  Additionally, a base class wouldn't serve any other purposes; it 
 //  wouldn't, for example, simplify the exception-handling code.
 
+#ifdef __STL_USE_STD_ALLOCATORS
+
+// Fills __out with __n nodes from __a.  An instanceless allocator can
+// hand them out in one batch through its _Alloc_type.
+template <class _Node, class _Allocator, bool _IsStatic>
+struct _Hashtable_node_batch {
+  static void _S_get(_Allocator& __a, size_t __n, _Node** __out) {
+    size_t __i = 0;
+    __STL_TRY {
+      for ( ; __i < __n; ++__i)
+        __out[__i] = __a.allocate(1);
+    }
+    __STL_UNWIND(while (__i > 0) __a.deallocate(__out[--__i], 1));
+  }
+};
+
+template <class _Node, class _Allocator>
+struct _Hashtable_node_batch<_Node, _Allocator, true> {
+  static void _S_get(_Allocator&, size_t __n, _Node** __out) {
+    _Alloc_traits<_Node, _Allocator>::_Alloc_type::allocate_n_nodes(__n,
+                                                                    __out);
+  }
+};
+
+#endif /* __STL_USE_STD_ALLOCATORS */
+
 template <class _Val, class _Key, class _HashFcn,
           class _ExtractKey, class _EqualKey, class _Alloc>
 class hashtable {
@@ -204,6 +279,7 @@ public:
 
 private:
   typedef _Hashtable_node<_Val> _Node;
+  typedef typename _Hashtable_bucket_policy<_HashFcn>::_Policy _Bucket_policy;
 
 #ifdef __STL_USE_STD_ALLOCATORS
 public:
@@ -213,6 +289,12 @@ private:
   typename _Alloc_traits<_Node, _Alloc>::allocator_type _M_node_allocator;
   _Node* _M_get_node() { return _M_node_allocator.allocate(1); }
   void _M_put_node(_Node* __p) { _M_node_allocator.deallocate(__p, 1); }
+  void _M_get_nodes(size_t __n, _Node** __out) {
+    _Hashtable_node_batch<_Node,
+      typename _Alloc_traits<_Node, _Alloc>::allocator_type,
+      _Alloc_traits<_Node, _Alloc>::_S_instanceless>
+        ::_S_get(_M_node_allocator, __n, __out);
+  }
 # define __HASH_ALLOC_INIT(__a) _M_node_allocator(__a), 
 #else /* __STL_USE_STD_ALLOCATORS */
 public:
@@ -222,6 +304,8 @@ private:
   typedef simple_alloc<_Node, _Alloc> _M_node_allocator_type;
   _Node* _M_get_node() { return _M_node_allocator_type::allocate(1); }
   void _M_put_node(_Node* __p) { _M_node_allocator_type::deallocate(__p, 1); }
+  void _M_get_nodes(size_t __n, _Node** __out)
+    { _M_node_allocator_type::allocate_n_nodes(__n, __out); }
 # define __HASH_ALLOC_INIT(__a)
 #endif /* __STL_USE_STD_ALLOCATORS */
 
@@ -231,6 +315,10 @@ private:
   _ExtractKey           _M_get_key;
   vector<_Node*,_Alloc> _M_buckets;
   size_type             _M_num_elements;
+#ifdef __STL_HASHTABLE_INCREMENTAL_REHASH
+  vector<_Node*,_Alloc> _M_old_buckets;   // Empty unless growing.
+  size_type             _M_rehash_pos;    // Old buckets below are empty.
+#endif /* __STL_HASHTABLE_INCREMENTAL_REHASH */
 
 public:
   typedef _Hashtable_iterator<_Val,_Key,_HashFcn,_ExtractKey,_EqualKey,_Alloc>
@@ -244,6 +332,12 @@ public:
   friend struct
   _Hashtable_const_iterator<_Val,_Key,_HashFcn,_ExtractKey,_EqualKey,_Alloc>;
 
+#ifdef __STL_HASHTABLE_INCREMENTAL_REHASH
+# define __HASH_REHASH_INIT(__a) , _M_old_buckets(__a), _M_rehash_pos(0)
+#else /* __STL_HASHTABLE_INCREMENTAL_REHASH */
+# define __HASH_REHASH_INIT(__a)
+#endif /* __STL_HASHTABLE_INCREMENTAL_REHASH */
+
 public:
   hashtable(size_type __n,
             const _HashFcn&    __hf,
@@ -256,6 +350,7 @@ public:
       _M_get_key(__ext),
       _M_buckets(__a),
       _M_num_elements(0)
+      __HASH_REHASH_INIT(__a)
   {
     _M_initialize_buckets(__n);
   }
@@ -270,6 +365,7 @@ public:
       _M_get_key(_ExtractKey()),
       _M_buckets(__a),
       _M_num_elements(0)
+      __HASH_REHASH_INIT(__a)
   {
     _M_initialize_buckets(__n);
   }
@@ -281,11 +377,26 @@ public:
       _M_get_key(__ht._M_get_key),
       _M_buckets(__ht.get_allocator()),
       _M_num_elements(0)
+      __HASH_REHASH_INIT(__ht.get_allocator())
+  {
+    _M_copy_from(__ht);
+  }
+
+  // A copy that allocates with __a; see _Construct_scoped.
+  hashtable(const hashtable& __ht, const allocator_type& __a)
+    : __HASH_ALLOC_INIT(__a)
+      _M_hash(__ht._M_hash),
+      _M_equals(__ht._M_equals),
+      _M_get_key(__ht._M_get_key),
+      _M_buckets(__a),
+      _M_num_elements(0)
+      __HASH_REHASH_INIT(__a)
   {
     _M_copy_from(__ht);
   }
 
 #undef __HASH_ALLOC_INIT
+#undef __HASH_REHASH_INIT
 
   hashtable& operator= (const hashtable& __ht)
   {
@@ -312,13 +423,17 @@ public:
     __STD::swap(_M_get_key, __ht._M_get_key);
     _M_buckets.swap(__ht._M_buckets);
     __STD::swap(_M_num_elements, __ht._M_num_elements);
+#ifdef __STL_HASHTABLE_INCREMENTAL_REHASH
+    _M_old_buckets.swap(__ht._M_old_buckets);
+    __STD::swap(_M_rehash_pos, __ht._M_rehash_pos);
+#endif /* __STL_HASHTABLE_INCREMENTAL_REHASH */
   }
 
   iterator begin()
   { 
-    for (size_type __n = 0; __n < _M_buckets.size(); ++__n)
-      if (_M_buckets[__n])
-        return iterator(_M_buckets[__n], this);
+    for (size_type __n = 0; __n < _M_bucket_end(); ++__n)
+      if (_M_bucket(__n))
+        return iterator(_M_bucket(__n), this);
     return end();
   }
 
@@ -326,9 +441,9 @@ public:
 
   const_iterator begin() const
   {
-    for (size_type __n = 0; __n < _M_buckets.size(); ++__n)
-      if (_M_buckets[__n])
-        return const_iterator(_M_buckets[__n], this);
+    for (size_type __n = 0; __n < _M_bucket_end(); ++__n)
+      if (_M_bucket(__n))
+        return const_iterator(_M_bucket(__n), this);
     return end();
   }
 
@@ -348,8 +463,10 @@ public:
   size_type bucket_count() const { return _M_buckets.size(); }
 
   size_type max_bucket_count() const
-    { return __stl_prime_list[(int)__stl_num_primes - 1]; } 
+    { return _Bucket_policy::_S_max_size(); }
 
+  // While the table is growing, counts only the elements already moved
+  // into the bucket.
   size_type elems_in_bucket(size_type __bucket) const
   {
     size_type __result = 0;
@@ -402,6 +519,7 @@ public:
       insert_equal(*__f);
   }
 
+  // The nodes come in batches.  A duplicate key does not use one up.
   template <class _ForwardIterator>
   void insert_unique(_ForwardIterator __f, _ForwardIterator __l,
                      forward_iterator_tag)
@@ -409,8 +527,31 @@ public:
     size_type __n = 0;
     distance(__f, __l, __n);
     resize(_M_num_elements + __n);
-    for ( ; __n > 0; --__n, ++__f)
-      insert_unique_noresize(*__f);
+    _Node* __nodes[__stl_node_batch];
+    size_type __have = 0;
+    size_type __used = 0;
+    __STL_TRY {
+      for ( ; __n > 0; --__n, ++__f) {
+        const value_type& __obj = *__f;
+        const size_type __h = _M_hash(_M_get_key(__obj));
+        const size_type __b = _M_bkt_num_code(__h);
+        if (0 != _M_find_in_bucket(__b, _M_get_key(__obj), __h))
+          continue;
+        if (__used == __have) {
+          // All used up, so there is nothing to give back if this throws.
+          size_type __k = __n < (size_type) __stl_node_batch
+                            ? __n : (size_type) __stl_node_batch;
+          _M_get_nodes(__k, __nodes);
+          __have = __k;
+          __used = 0;
+        }
+        _M_link_node(__b, 0, __nodes[__used], __obj, __h);
+        ++__used;
+      }
+    }
+    __STL_UNWIND(while (__used < __have) _M_put_node(__nodes[__used++]));
+    while (__used < __have)
+      _M_put_node(__nodes[__used++]);
   }
 
   template <class _ForwardIterator>
@@ -420,8 +561,24 @@ public:
     size_type __n = 0;
     distance(__f, __l, __n);
     resize(_M_num_elements + __n);
-    for ( ; __n > 0; --__n, ++__f)
-      insert_equal_noresize(*__f);
+    _Node* __nodes[__stl_node_batch];
+    while (__n > 0) {
+      size_type __k = __n < (size_type) __stl_node_batch
+                        ? __n : (size_type) __stl_node_batch;
+      _M_get_nodes(__k, __nodes);
+      size_type __i = 0;
+      __STL_TRY {
+        for ( ; __i < __k; ++__i, ++__f) {
+          const value_type& __obj = *__f;
+          const size_type __h = _M_hash(_M_get_key(__obj));
+          const size_type __b = _M_bkt_num_code(__h);
+          _M_link_node(__b, _M_find_in_bucket(__b, _M_get_key(__obj), __h),
+                       __nodes[__i], __obj, __h);
+        }
+      }
+      __STL_UNWIND(for ( ; __i < __k; ++__i) _M_put_node(__nodes[__i]));
+      __n -= __k;
+    }
   }
 
 #else /* __STL_MEMBER_TEMPLATES */
@@ -464,10 +621,11 @@ public:
 
   iterator find(const key_type& __key) 
   {
-    size_type __n = _M_bkt_num_key(__key);
+    const size_type __h = _M_hash(__key);
+    size_type __n = _M_bkt_num_code(__h);
     _Node* __first;
-    for ( __first = _M_buckets[__n];
-          __first && !_M_equals(_M_get_key(__first->_M_val), __key);
+    for ( __first = _M_bucket(__n);
+          __first && !_M_node_matches(__first, __key, __h);
           __first = __first->_M_next)
       {}
     return iterator(__first, this);
@@ -475,10 +633,11 @@ public:
 
   const_iterator find(const key_type& __key) const
   {
-    size_type __n = _M_bkt_num_key(__key);
+    const size_type __h = _M_hash(__key);
+    size_type __n = _M_bkt_num_code(__h);
     const _Node* __first;
-    for ( __first = _M_buckets[__n];
-          __first && !_M_equals(_M_get_key(__first->_M_val), __key);
+    for ( __first = _M_bucket(__n);
+          __first && !_M_node_matches(__first, __key, __h);
           __first = __first->_M_next)
       {}
     return const_iterator(__first, this);
@@ -486,11 +645,12 @@ public:
 
   size_type count(const key_type& __key) const
   {
-    const size_type __n = _M_bkt_num_key(__key);
+    const size_type __h = _M_hash(__key);
+    const size_type __n = _M_bkt_num_code(__h);
     size_type __result = 0;
 
-    for (const _Node* __cur = _M_buckets[__n]; __cur; __cur = __cur->_M_next)
-      if (_M_equals(_M_get_key(__cur->_M_val), __key))
+    for (const _Node* __cur = _M_bucket(__n); __cur; __cur = __cur->_M_next)
+      if (_M_node_matches(__cur, __key, __h))
         ++__result;
     return __result;
   }
@@ -513,7 +673,7 @@ public:
 
 private:
   size_type _M_next_size(size_type __n) const
-    { return __stl_next_prime(__n); }
+    { return _Bucket_policy::_S_next_size(__n); }
 
   void _M_initialize_buckets(size_type __n)
   {
@@ -523,43 +683,142 @@ private:
     _M_num_elements = 0;
   }
 
-  size_type _M_bkt_num_key(const key_type& __key) const
+  // The bucket for hash code __h.  Buckets are numbered across
+  // _M_old_buckets and then _M_buckets.  A key stays in its old bucket
+  // until _M_rehash_step reaches it.
+  size_type _M_bkt_num_code(size_type __h) const
+  {
+#ifdef __STL_HASHTABLE_INCREMENTAL_REHASH
+    if (!_M_old_buckets.empty()) {
+      const size_type __old = _M_bkt_index(__h, _M_old_buckets.size());
+      return __old >= _M_rehash_pos
+        ? __old : _M_old_buckets.size() + _M_bkt_index(__h, _M_buckets.size());
+    }
+#endif /* __STL_HASHTABLE_INCREMENTAL_REHASH */
+    return _M_bkt_index(__h, _M_buckets.size());
+  }
+
+#ifdef __STL_HASHTABLE_INCREMENTAL_REHASH
+  _Node*& _M_bucket(size_type __n)
+  {
+    return __n < _M_old_buckets.size()
+      ? _M_old_buckets[__n] : _M_buckets[__n - _M_old_buckets.size()];
+  }
+  _Node* _M_bucket(size_type __n) const
   {
-    return _M_bkt_num_key(__key, _M_buckets.size());
+    return __n < _M_old_buckets.size()
+      ? _M_old_buckets[__n] : _M_buckets[__n - _M_old_buckets.size()];
   }
+  size_type _M_bucket_end() const
+    { return _M_old_buckets.size() + _M_buckets.size(); }
+
+  void _M_rehash_step(size_type __count);
+#else /* __STL_HASHTABLE_INCREMENTAL_REHASH */
+  _Node*& _M_bucket(size_type __n) { return _M_buckets[__n]; }
+  _Node* _M_bucket(size_type __n) const { return _M_buckets[__n]; }
+  size_type _M_bucket_end() const { return _M_buckets.size(); }
+#endif /* __STL_HASHTABLE_INCREMENTAL_REHASH */
 
-  size_type _M_bkt_num(const value_type& __obj) const
+  size_type _M_bkt_num_node(const _Node* __n) const
   {
-    return _M_bkt_num_key(_M_get_key(__obj));
+    return _M_bkt_num_code(_M_hash_code(__n));
   }
 
-  size_type _M_bkt_num_key(const key_type& __key, size_t __n) const
+  static size_type _M_bkt_index(size_type __h, size_t __n)
   {
-    return _M_hash(__key) % __n;
+    return _Bucket_policy::_S_index(__h, __n);
   }
 
-  size_type _M_bkt_num(const value_type& __obj, size_t __n) const
+  // The hash code of the element in __n.
+  size_type _M_hash_code(const _Node* __n) const
   {
-    return _M_bkt_num_key(_M_get_key(__obj), __n);
+#ifdef __STL_HASHTABLE_CACHE_HASH
+    return __n->_M_hash_code;
+#else /* __STL_HASHTABLE_CACHE_HASH */
+    return _M_hash(_M_get_key(__n->_M_val));
+#endif /* __STL_HASHTABLE_CACHE_HASH */
   }
 
-  _Node* _M_new_node(const value_type& __obj)
+  // Whether the element in __n has the key __k, whose hash code is __h.
+  // With cached hash codes, a mismatch rarely costs a call to _M_equals.
+#ifdef __STL_HASHTABLE_CACHE_HASH
+  bool _M_node_matches(const _Node* __n, const key_type& __k,
+                       size_type __h) const
+  {
+    return __n->_M_hash_code == __h
+        && _M_equals(_M_get_key(__n->_M_val), __k);
+  }
+
+  static void _M_set_hash_code(_Node* __n, size_type __h)
+    { __n->_M_hash_code = __h; }
+#else /* __STL_HASHTABLE_CACHE_HASH */
+  bool _M_node_matches(const _Node* __n, const key_type& __k,
+                       size_type /* __h */) const
+  {
+    return _M_equals(_M_get_key(__n->_M_val), __k);
+  }
+
+  static void _M_set_hash_code(_Node* /* __n */, size_type /* __h */) {}
+#endif /* __STL_HASHTABLE_CACHE_HASH */
+
+  // __h is the hash code of __obj's key.
+  _Node* _M_new_node(const value_type& __obj, size_type __h)
   {
     _Node* __n = _M_get_node();
     __n->_M_next = 0;
+    _M_set_hash_code(__n, __h);
     __STL_TRY {
-      construct(&__n->_M_val, __obj);
+      _Construct_scoped(&__n->_M_val, __obj, get_allocator());
       return __n;
     }
     __STL_UNWIND(_M_put_node(__n));
   }
   
+  // A new node holding a copy of the element in __n and its hash code.
+  // Never calls the hash function.
+  _Node* _M_copy_node(const _Node* __n)
+  {
+#ifdef __STL_HASHTABLE_CACHE_HASH
+    return _M_new_node(__n->_M_val, __n->_M_hash_code);
+#else /* __STL_HASHTABLE_CACHE_HASH */
+    return _M_new_node(__n->_M_val, 0);
+#endif /* __STL_HASHTABLE_CACHE_HASH */
+  }
+
   void _M_delete_node(_Node* __n)
   {
     destroy(&__n->_M_val);
     _M_put_node(__n);
   }
 
+  // The first element of bucket __b with key __k, whose hash code is
+  // __h, or 0.
+  _Node* _M_find_in_bucket(size_type __b, const key_type& __k, size_type __h)
+  {
+    _Node* __cur = _M_bucket(__b);
+    while (__cur && !_M_node_matches(__cur, __k, __h))
+      __cur = __cur->_M_next;
+    return __cur;
+  }
+
+  // Constructs __obj in the unused node __tmp and links it in bucket
+  // __b, after __prev or, if __prev is 0, at the front.  __tmp is still
+  // the caller's to free if construction throws.
+  void _M_link_node(size_type __b, _Node* __prev, _Node* __tmp,
+                    const value_type& __obj, size_type __h)
+  {
+    _Construct_scoped(&__tmp->_M_val, __obj, get_allocator());
+    _M_set_hash_code(__tmp, __h);
+    if (__prev) {
+      __tmp->_M_next = __prev->_M_next;
+      __prev->_M_next = __tmp;
+    } else {
+      __tmp->_M_next = _M_bucket(__b);
+      _M_bucket(__b) = __tmp;
+    }
+    ++_M_num_elements;
+  }
+
   void _M_erase_bucket(const size_type __n, _Node* __first, _Node* __last);
   void _M_erase_bucket(const size_type __n, _Node* __last);
 
@@ -575,9 +834,9 @@ _Hashtable_iterator<_Val,_Key,_HF,_ExK,_EqK,_All>::operator++()
   const _Node* __old = _M_cur;
   _M_cur = _M_cur->_M_next;
   if (!_M_cur) {
-    size_type __bucket = _M_ht->_M_bkt_num(__old->_M_val);
-    while (!_M_cur && ++__bucket < _M_ht->_M_buckets.size())
-      _M_cur = _M_ht->_M_buckets[__bucket];
+    size_type __bucket = _M_ht->_M_bkt_num_node(__old);
+    while (!_M_cur && ++__bucket < _M_ht->_M_bucket_end())
+      _M_cur = _M_ht->_M_bucket(__bucket);
   }
   return *this;
 }
@@ -600,9 +859,9 @@ _Hashtable_const_iterator<_Val,_Key,_HF,_ExK,_EqK,_All>::operator++()
   const _Node* __old = _M_cur;
   _M_cur = _M_cur->_M_next;
   if (!_M_cur) {
-    size_type __bucket = _M_ht->_M_bkt_num(__old->_M_val);
-    while (!_M_cur && ++__bucket < _M_ht->_M_buckets.size())
-      _M_cur = _M_ht->_M_buckets[__bucket];
+    size_type __bucket = _M_ht->_M_bkt_num_node(__old);
+    while (!_M_cur && ++__bucket < _M_ht->_M_bucket_end())
+      _M_cur = _M_ht->_M_bucket(__bucket);
   }
   return *this;
 }
@@ -675,11 +934,11 @@ bool operator==(const hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>& __ht1,
                 const hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>& __ht2)
 {
   typedef typename hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::_Node _Node;
-  if (__ht1._M_buckets.size() != __ht2._M_buckets.size())
+  if (__ht1._M_bucket_end() != __ht2._M_bucket_end())
     return false;
-  for (int __n = 0; __n < __ht1._M_buckets.size(); ++__n) {
-    _Node* __cur1 = __ht1._M_buckets[__n];
-    _Node* __cur2 = __ht2._M_buckets[__n];
+  for (int __n = 0; __n < __ht1._M_bucket_end(); ++__n) {
+    _Node* __cur1 = __ht1._M_bucket(__n);
+    _Node* __cur2 = __ht2._M_bucket(__n);
     for ( ; __cur1 && __cur2 && __cur1->_M_val == __cur2->_M_val;
           __cur1 = __cur1->_M_next, __cur2 = __cur2->_M_next)
       {}
@@ -712,16 +971,17 @@ pair<typename hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::iterator, bool>
 hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
   ::insert_unique_noresize(const value_type& __obj)
 {
-  const size_type __n = _M_bkt_num(__obj);
-  _Node* __first = _M_buckets[__n];
+  const size_type __h = _M_hash(_M_get_key(__obj));
+  const size_type __n = _M_bkt_num_code(__h);
+  _Node* __first = _M_bucket(__n);
 
   for (_Node* __cur = __first; __cur; __cur = __cur->_M_next) 
-    if (_M_equals(_M_get_key(__cur->_M_val), _M_get_key(__obj)))
+    if (_M_node_matches(__cur, _M_get_key(__obj), __h))
       return pair<iterator, bool>(iterator(__cur, this), false);
 
-  _Node* __tmp = _M_new_node(__obj);
+  _Node* __tmp = _M_new_node(__obj, __h);
   __tmp->_M_next = __first;
-  _M_buckets[__n] = __tmp;
+  _M_bucket(__n) = __tmp;
   ++_M_num_elements;
   return pair<iterator, bool>(iterator(__tmp, this), true);
 }
@@ -731,21 +991,22 @@ typename hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::iterator
 hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
   ::insert_equal_noresize(const value_type& __obj)
 {
-  const size_type __n = _M_bkt_num(__obj);
-  _Node* __first = _M_buckets[__n];
+  const size_type __h = _M_hash(_M_get_key(__obj));
+  const size_type __n = _M_bkt_num_code(__h);
+  _Node* __first = _M_bucket(__n);
 
   for (_Node* __cur = __first; __cur; __cur = __cur->_M_next) 
-    if (_M_equals(_M_get_key(__cur->_M_val), _M_get_key(__obj))) {
-      _Node* __tmp = _M_new_node(__obj);
+    if (_M_node_matches(__cur, _M_get_key(__obj), __h)) {
+      _Node* __tmp = _M_new_node(__obj, __h);
       __tmp->_M_next = __cur->_M_next;
       __cur->_M_next = __tmp;
       ++_M_num_elements;
       return iterator(__tmp, this);
     }
 
-  _Node* __tmp = _M_new_node(__obj);
+  _Node* __tmp = _M_new_node(__obj, __h);
   __tmp->_M_next = __first;
-  _M_buckets[__n] = __tmp;
+  _M_bucket(__n) = __tmp;
   ++_M_num_elements;
   return iterator(__tmp, this);
 }
@@ -756,16 +1017,17 @@ hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::find_or_insert(const value_type& __obj)
 {
   resize(_M_num_elements + 1);
 
-  size_type __n = _M_bkt_num(__obj);
-  _Node* __first = _M_buckets[__n];
+  const size_type __h = _M_hash(_M_get_key(__obj));
+  size_type __n = _M_bkt_num_code(__h);
+  _Node* __first = _M_bucket(__n);
 
   for (_Node* __cur = __first; __cur; __cur = __cur->_M_next)
-    if (_M_equals(_M_get_key(__cur->_M_val), _M_get_key(__obj)))
+    if (_M_node_matches(__cur, _M_get_key(__obj), __h))
       return __cur->_M_val;
 
-  _Node* __tmp = _M_new_node(__obj);
+  _Node* __tmp = _M_new_node(__obj, __h);
   __tmp->_M_next = __first;
-  _M_buckets[__n] = __tmp;
+  _M_bucket(__n) = __tmp;
   ++_M_num_elements;
   return __tmp->_M_val;
 }
@@ -776,17 +1038,18 @@ pair<typename hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::iterator,
 hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::equal_range(const key_type& __key)
 {
   typedef pair<iterator, iterator> _Pii;
-  const size_type __n = _M_bkt_num_key(__key);
+  const size_type __h = _M_hash(__key);
+  const size_type __n = _M_bkt_num_code(__h);
 
-  for (_Node* __first = _M_buckets[__n]; __first; __first = __first->_M_next)
-    if (_M_equals(_M_get_key(__first->_M_val), __key)) {
+  for (_Node* __first = _M_bucket(__n); __first; __first = __first->_M_next)
+    if (_M_node_matches(__first, __key, __h)) {
       for (_Node* __cur = __first->_M_next; __cur; __cur = __cur->_M_next)
-        if (!_M_equals(_M_get_key(__cur->_M_val), __key))
+        if (!_M_node_matches(__cur, __key, __h))
           return _Pii(iterator(__first, this), iterator(__cur, this));
-      for (size_type __m = __n + 1; __m < _M_buckets.size(); ++__m)
-        if (_M_buckets[__m])
+      for (size_type __m = __n + 1; __m < _M_bucket_end(); ++__m)
+        if (_M_bucket(__m))
           return _Pii(iterator(__first, this),
-                     iterator(_M_buckets[__m], this));
+                     iterator(_M_bucket(__m), this));
       return _Pii(iterator(__first, this), end());
     }
   return _Pii(end(), end());
@@ -799,22 +1062,23 @@ hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
   ::equal_range(const key_type& __key) const
 {
   typedef pair<const_iterator, const_iterator> _Pii;
-  const size_type __n = _M_bkt_num_key(__key);
+  const size_type __h = _M_hash(__key);
+  const size_type __n = _M_bkt_num_code(__h);
 
-  for (const _Node* __first = _M_buckets[__n] ;
+  for (const _Node* __first = _M_bucket(__n) ;
        __first; 
        __first = __first->_M_next) {
-    if (_M_equals(_M_get_key(__first->_M_val), __key)) {
+    if (_M_node_matches(__first, __key, __h)) {
       for (const _Node* __cur = __first->_M_next;
            __cur;
            __cur = __cur->_M_next)
-        if (!_M_equals(_M_get_key(__cur->_M_val), __key))
+        if (!_M_node_matches(__cur, __key, __h))
           return _Pii(const_iterator(__first, this),
                       const_iterator(__cur, this));
-      for (size_type __m = __n + 1; __m < _M_buckets.size(); ++__m)
-        if (_M_buckets[__m])
+      for (size_type __m = __n + 1; __m < _M_bucket_end(); ++__m)
+        if (_M_bucket(__m))
           return _Pii(const_iterator(__first, this),
-                      const_iterator(_M_buckets[__m], this));
+                      const_iterator(_M_bucket(__m), this));
       return _Pii(const_iterator(__first, this), end());
     }
   }
@@ -825,15 +1089,16 @@ template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
 typename hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::size_type 
 hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::erase(const key_type& __key)
 {
-  const size_type __n = _M_bkt_num_key(__key);
-  _Node* __first = _M_buckets[__n];
+  const size_type __h = _M_hash(__key);
+  const size_type __n = _M_bkt_num_code(__h);
+  _Node* __first = _M_bucket(__n);
   size_type __erased = 0;
 
   if (__first) {
     _Node* __cur = __first;
     _Node* __next = __cur->_M_next;
     while (__next) {
-      if (_M_equals(_M_get_key(__next->_M_val), __key)) {
+      if (_M_node_matches(__next, __key, __h)) {
         __cur->_M_next = __next->_M_next;
         _M_delete_node(__next);
         __next = __cur->_M_next;
@@ -845,8 +1110,8 @@ hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::erase(const key_type& __key)
         __next = __cur->_M_next;
       }
     }
-    if (_M_equals(_M_get_key(__first->_M_val), __key)) {
-      _M_buckets[__n] = __first->_M_next;
+    if (_M_node_matches(__first, __key, __h)) {
+      _M_bucket(__n) = __first->_M_next;
       _M_delete_node(__first);
       ++__erased;
       --_M_num_elements;
@@ -860,11 +1125,11 @@ void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::erase(const iterator& __it)
 {
   _Node* __p = __it._M_cur;
   if (__p) {
-    const size_type __n = _M_bkt_num(__p->_M_val);
-    _Node* __cur = _M_buckets[__n];
+    const size_type __n = _M_bkt_num_node(__p);
+    _Node* __cur = _M_bucket(__n);
 
     if (__cur == __p) {
-      _M_buckets[__n] = __cur->_M_next;
+      _M_bucket(__n) = __cur->_M_next;
       _M_delete_node(__cur);
       --_M_num_elements;
     }
@@ -891,9 +1156,9 @@ void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
   ::erase(iterator __first, iterator __last)
 {
   size_type __f_bucket = __first._M_cur ? 
-    _M_bkt_num(__first._M_cur->_M_val) : _M_buckets.size();
+    _M_bkt_num_node(__first._M_cur) : _M_bucket_end();
   size_type __l_bucket = __last._M_cur ? 
-    _M_bkt_num(__last._M_cur->_M_val) : _M_buckets.size();
+    _M_bkt_num_node(__last._M_cur) : _M_bucket_end();
 
   if (__first._M_cur == __last._M_cur)
     return;
@@ -903,7 +1168,7 @@ void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
     _M_erase_bucket(__f_bucket, __first._M_cur, 0);
     for (size_type __n = __f_bucket + 1; __n < __l_bucket; ++__n)
       _M_erase_bucket(__n, 0);
-    if (__l_bucket != _M_buckets.size())
+    if (__l_bucket != _M_bucket_end())
       _M_erase_bucket(__l_bucket, __last._M_cur);
   }
 }
@@ -931,6 +1196,28 @@ template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
 void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
   ::resize(size_type __num_elements_hint)
 {
+#ifdef __STL_HASHTABLE_INCREMENTAL_REHASH
+  const size_type __old_n = _M_buckets.size();
+  if (__num_elements_hint > __old_n) {
+    const size_type __n = _M_next_size(__num_elements_hint);
+    if (__n > __old_n) {
+      vector<_Node*, _All> __tmp(__n, (_Node*)(0),
+                                 _M_buckets.get_allocator());
+      // The current buckets become the old ones, emptied a few at a
+      // time by later insertions.  A rehash still under way is finished
+      // first.
+      _M_rehash_step(_M_old_buckets.size());
+      _M_old_buckets.swap(_M_buckets);
+      _M_buckets.swap(__tmp);
+      // A range insertion that more than doubles the table would link
+      // most of its elements into the few old buckets: move them all
+      // now, as the range costs that much anyway.
+      if (__num_elements_hint > 2 * __old_n)
+        _M_rehash_step(_M_old_buckets.size());
+    }
+  }
+  _M_rehash_step(__stl_rehash_step);
+#else /* __STL_HASHTABLE_INCREMENTAL_REHASH */
   const size_type __old_n = _M_buckets.size();
   if (__num_elements_hint > __old_n) {
     const size_type __n = _M_next_size(__num_elements_hint);
@@ -941,7 +1228,8 @@ void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
         for (size_type __bucket = 0; __bucket < __old_n; ++__bucket) {
           _Node* __first = _M_buckets[__bucket];
           while (__first) {
-            size_type __new_bucket = _M_bkt_num(__first->_M_val, __n);
+            size_type __new_bucket =
+              _M_bkt_index(_M_hash_code(__first), __n);
             _M_buckets[__bucket] = __first->_M_next;
             __first->_M_next = __tmp[__new_bucket];
             __tmp[__new_bucket] = __first;
@@ -964,13 +1252,44 @@ void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
 #         endif /* __STL_USE_EXCEPTIONS */
     }
   }
+#endif /* __STL_HASHTABLE_INCREMENTAL_REHASH */
 }
 
+#ifdef __STL_HASHTABLE_INCREMENTAL_REHASH
+
+// Moves the elements of the next __count old buckets into _M_buckets.
+// Every element is in one bucket or the other at all times, so a hash
+// function that throws leaves the table intact.
+template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
+void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
+  ::_M_rehash_step(size_type __count)
+{
+  const size_type __n = _M_buckets.size();
+  for ( ; __count > 0 && _M_rehash_pos < _M_old_buckets.size(); --__count) {
+    _Node* __first = _M_old_buckets[_M_rehash_pos];
+    while (__first) {
+      size_type __new_bucket = _M_bkt_index(_M_hash_code(__first), __n);
+      _M_old_buckets[_M_rehash_pos] = __first->_M_next;
+      __first->_M_next = _M_buckets[__new_bucket];
+      _M_buckets[__new_bucket] = __first;
+      __first = _M_old_buckets[_M_rehash_pos];
+    }
+    ++_M_rehash_pos;
+  }
+  if (_M_rehash_pos == _M_old_buckets.size() && _M_rehash_pos != 0) {
+    vector<_Node*, _All> __empty(_M_buckets.get_allocator());
+    _M_old_buckets.swap(__empty);
+    _M_rehash_pos = 0;
+  }
+}
+
+#endif /* __STL_HASHTABLE_INCREMENTAL_REHASH */
+
 template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
 void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
   ::_M_erase_bucket(const size_type __n, _Node* __first, _Node* __last)
 {
-  _Node* __cur = _M_buckets[__n];
+  _Node* __cur = _M_bucket(__n);
   if (__cur == __first)
     _M_erase_bucket(__n, __last);
   else {
@@ -992,12 +1311,12 @@ template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
 void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
   ::_M_erase_bucket(const size_type __n, _Node* __last)
 {
-  _Node* __cur = _M_buckets[__n];
+  _Node* __cur = _M_bucket(__n);
   while (__cur != __last) {
     _Node* __next = __cur->_M_next;
     _M_delete_node(__cur);
     __cur = __next;
-    _M_buckets[__n] = __cur;
+    _M_bucket(__n) = __cur;
     --_M_num_elements;
   }
 }
@@ -1005,16 +1324,20 @@ void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
 template <class _Val, class _Key, class _HF, class _Ex, class _Eq, class _All>
 void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>::clear()
 {
-  for (size_type __i = 0; __i < _M_buckets.size(); ++__i) {
-    _Node* __cur = _M_buckets[__i];
+  for (size_type __i = 0; __i < _M_bucket_end(); ++__i) {
+    _Node* __cur = _M_bucket(__i);
     while (__cur != 0) {
       _Node* __next = __cur->_M_next;
       _M_delete_node(__cur);
       __cur = __next;
     }
-    _M_buckets[__i] = 0;
+    _M_bucket(__i) = 0;
   }
   _M_num_elements = 0;
+#ifdef __STL_HASHTABLE_INCREMENTAL_REHASH
+  _M_rehash_pos = _M_old_buckets.size();
+  _M_rehash_step(0);
+#endif /* __STL_HASHTABLE_INCREMENTAL_REHASH */
 }
 
     
@@ -1025,17 +1348,23 @@ void hashtable<_Val,_Key,_HF,_Ex,_Eq,_All>
   _M_buckets.clear();
   _M_buckets.reserve(__ht._M_buckets.size());
   _M_buckets.insert(_M_buckets.end(), __ht._M_buckets.size(), (_Node*) 0);
+#ifdef __STL_HASHTABLE_INCREMENTAL_REHASH
+  // The copy is part way through the same rehash.
+  _M_old_buckets.insert(_M_old_buckets.end(), __ht._M_old_buckets.size(),
+                        (_Node*) 0);
+  _M_rehash_pos = __ht._M_rehash_pos;
+#endif /* __STL_HASHTABLE_INCREMENTAL_REHASH */
   __STL_TRY {
-    for (size_type __i = 0; __i < __ht._M_buckets.size(); ++__i) {
-      const _Node* __cur = __ht._M_buckets[__i];
+    for (size_type __i = 0; __i < __ht._M_bucket_end(); ++__i) {
+      const _Node* __cur = __ht._M_bucket(__i);
       if (__cur) {
-        _Node* __copy = _M_new_node(__cur->_M_val);
-        _M_buckets[__i] = __copy;
+        _Node* __copy = _M_copy_node(__cur);
+        _M_bucket(__i) = __copy;
 
         for (_Node* __next = __cur->_M_next; 
              __next; 
              __cur = __next, __next = __cur->_M_next) {
-          __copy->_M_next = _M_new_node(__next->_M_val);
+          __copy->_M_next = _M_copy_node(__next);
           __copy = __copy->_M_next;
         }
       }
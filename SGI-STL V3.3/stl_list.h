@@ -160,6 +160,14 @@ protected:
    { return _Node_allocator.allocate(1); }
   void _M_put_node(_List_node<_Tp>* __p)
     { _Node_allocator.deallocate(__p, 1); }
+  void _M_get_nodes(size_t __n, _List_node<_Tp>** __out) {
+    size_t __i = 0;
+    __STL_TRY {
+      for ( ; __i < __n; ++__i)
+        __out[__i] = _Node_allocator.allocate(1);
+    }
+    __STL_UNWIND(while (__i > 0) _Node_allocator.deallocate(__out[--__i], 1));
+  }
 
 protected:
   typename _Alloc_traits<_List_node<_Tp>, _Allocator>::allocator_type
@@ -183,6 +191,8 @@ protected:
           _Alloc_type;
   _List_node<_Tp>* _M_get_node() { return _Alloc_type::allocate(1); }
   void _M_put_node(_List_node<_Tp>* __p) { _Alloc_type::deallocate(__p, 1); }
+  void _M_get_nodes(size_t __n, _List_node<_Tp>** __out)
+    { _Alloc_type::allocate_n_nodes(__n, __out); }
 
 protected:
   _List_node<_Tp>* _M_node;
@@ -237,6 +247,8 @@ protected:
   typedef simple_alloc<_List_node<_Tp>, _Alloc> _Alloc_type;
   _List_node<_Tp>* _M_get_node() { return _Alloc_type::allocate(1); }
   void _M_put_node(_List_node<_Tp>* __p) { _Alloc_type::deallocate(__p, 1); } 
+  void _M_get_nodes(size_t __n, _List_node<_Tp>** __out)
+    { _Alloc_type::allocate_n_nodes(__n, __out); }
 
 protected:
   _List_node<_Tp>* _M_node;
@@ -303,6 +315,7 @@ protected:
   using _Base::_M_node;
   using _Base::_M_put_node;
   using _Base::_M_get_node;
+  using _Base::_M_get_nodes;
 #endif /* __STL_HAS_NAMESPACES */
 
 protected:
@@ -310,7 +323,7 @@ protected:
   {
     _Node* __p = _M_get_node();
     __STL_TRY {
-      _Construct(&__p->_M_data, __x);
+      _Construct_scoped(&__p->_M_data, __x, get_allocator());
     }
     __STL_UNWIND(_M_put_node(__p));
     return __p;
@@ -326,6 +339,14 @@ protected:
     return __p;
   }
 
+  void _M_link_before(iterator __position, _Node* __tmp)
+  {
+    __tmp->_M_next = __position._M_node;
+    __tmp->_M_prev = __position._M_node->_M_prev;
+    __position._M_node->_M_prev->_M_next = __tmp;
+    __position._M_node->_M_prev = __tmp;
+  }
+
 public:
   explicit list(const allocator_type& __a = allocator_type()) : _Base(__a) {}
 
@@ -362,10 +383,7 @@ public:
 
   iterator insert(iterator __position, const _Tp& __x) {
     _Node* __tmp = _M_create_node(__x);
-    __tmp->_M_next = __position._M_node;
-    __tmp->_M_prev = __position._M_node->_M_prev;
-    __position._M_node->_M_prev->_M_next = __tmp;
-    __position._M_node->_M_prev = __tmp;
+    _M_link_before(__position, __tmp);
     return __tmp;
   }
   iterator insert(iterator __position) { return insert(__position, _Tp()); }
@@ -381,7 +399,20 @@ public:
   template <class _InputIterator>
   void _M_insert_dispatch(iterator __pos,
                           _InputIterator __first, _InputIterator __last,
-                          __false_type);
+                          __false_type) {
+    _M_range_insert(__pos, __first, __last, __ITERATOR_CATEGORY(__first));
+  }
+
+  template <class _InputIterator>
+  void _M_range_insert(iterator __pos,
+                       _InputIterator __first, _InputIterator __last,
+                       input_iterator_tag);
+
+  // The length is known up front, so the nodes are obtained in batches.
+  template <class _ForwardIterator>
+  void _M_range_insert(iterator __pos,
+                       _ForwardIterator __first, _ForwardIterator __last,
+                       forward_iterator_tag);
 
   template <class _InputIterator>
   void insert(iterator __pos, _InputIterator __first, _InputIterator __last) {
@@ -457,6 +488,10 @@ public:
   list(const list<_Tp, _Alloc>& __x) : _Base(__x.get_allocator())
     { insert(begin(), __x.begin(), __x.end()); }
 
+  // A copy that allocates with __a; see _Construct_scoped.
+  list(const list<_Tp, _Alloc>& __x, const allocator_type& __a) : _Base(__a)
+    { insert(begin(), __x.begin(), __x.end()); }
+
   ~list() { }
 
   list<_Tp, _Alloc>& operator=(const list<_Tp, _Alloc>& __x);
@@ -594,18 +629,50 @@ swap(list<_Tp, _Alloc>& __x, list<_Tp, _Alloc>& __y)
 
 #endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
 
+#if defined(__STL_USE_STD_ALLOCATORS) && \
+    defined(__STL_CLASS_PARTIAL_SPECIALIZATION)
+template <class _Tp, class _Alloc, class _Outer>
+struct _Uses_allocator<list<_Tp, _Alloc>, _Outer>
+  : public _Scoped_alloc_check<_Tp, _Alloc, _Outer> {};
+#endif
+
 #ifdef __STL_MEMBER_TEMPLATES
 
 template <class _Tp, class _Alloc> template <class _InputIter>
 void 
-list<_Tp, _Alloc>::_M_insert_dispatch(iterator __position,
-                                      _InputIter __first, _InputIter __last,
-                                      __false_type)
+list<_Tp, _Alloc>::_M_range_insert(iterator __position,
+                                   _InputIter __first, _InputIter __last,
+                                   input_iterator_tag)
 {
   for ( ; __first != __last; ++__first)
     insert(__position, *__first);
 }
 
+template <class _Tp, class _Alloc> template <class _ForwardIter>
+void 
+list<_Tp, _Alloc>::_M_range_insert(iterator __position,
+                                   _ForwardIter __first, _ForwardIter __last,
+                                   forward_iterator_tag)
+{
+  size_type __n = 0;
+  distance(__first, __last, __n);
+  _Node* __nodes[__stl_node_batch];
+  while (__n > 0) {
+    size_type __k = __n < (size_type) __stl_node_batch
+                      ? __n : (size_type) __stl_node_batch;
+    _M_get_nodes(__k, __nodes);
+    size_type __i = 0;
+    __STL_TRY {
+      for ( ; __i < __k; ++__i, ++__first) {
+        _Construct_scoped(&__nodes[__i]->_M_data, *__first, get_allocator());
+        _M_link_before(__position, __nodes[__i]);
+      }
+    }
+    __STL_UNWIND(for ( ; __i < __k; ++__i) _M_put_node(__nodes[__i]));
+    __n -= __k;
+  }
+}
+
 #else /* __STL_MEMBER_TEMPLATES */
 
 template <class _Tp, class _Alloc>
@@ -633,8 +700,21 @@ void
 list<_Tp, _Alloc>::_M_fill_insert(iterator __position,
                                   size_type __n, const _Tp& __x)
 {
-  for ( ; __n > 0; --__n)
-    insert(__position, __x);
+  _Node* __nodes[__stl_node_batch];
+  while (__n > 0) {
+    size_type __k = __n < (size_type) __stl_node_batch
+                      ? __n : (size_type) __stl_node_batch;
+    _M_get_nodes(__k, __nodes);
+    size_type __i = 0;
+    __STL_TRY {
+      for ( ; __i < __k; ++__i) {
+        _Construct_scoped(&__nodes[__i]->_M_data, __x, get_allocator());
+        _M_link_before(__position, __nodes[__i]);
+      }
+    }
+    __STL_UNWIND(for ( ; __i < __k; ++__i) _M_put_node(__nodes[__i]));
+    __n -= __k;
+  }
 }
 
 template <class _Tp, class _Alloc>
@@ -138,6 +138,9 @@ public:
 #endif /* __STL_MEMBER_TEMPLATES */
 
   map(const map<_Key,_Tp,_Compare,_Alloc>& __x) : _M_t(__x._M_t) {}
+  // A copy that allocates with __a; see _Construct_scoped.
+  map(const map<_Key,_Tp,_Compare,_Alloc>& __x, const allocator_type& __a)
+    : _M_t(__x._M_t, __a) {}
   map<_Key,_Tp,_Compare,_Alloc>&
   operator=(const map<_Key, _Tp, _Compare, _Alloc>& __x)
   {
@@ -281,6 +284,13 @@ inline void swap(map<_Key,_Tp,_Compare,_Alloc>& __x,
 
 #endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
 
+#if defined(__STL_USE_STD_ALLOCATORS) && \
+    defined(__STL_CLASS_PARTIAL_SPECIALIZATION)
+template <class _Key, class _Tp, class _Compare, class _Alloc, class _Outer>
+struct _Uses_allocator<map<_Key,_Tp,_Compare,_Alloc>, _Outer>
+  : public _Scoped_alloc_check<pair<const _Key, _Tp>, _Alloc, _Outer> {};
+#endif
+
 #if defined(__sgi) && !defined(__GNUC__) && (_MIPS_SIM != _MIPS_SIM_ABI32)
 #pragma reset woff 1174
 #pragma reset woff 1375
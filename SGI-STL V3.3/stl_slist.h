@@ -342,7 +342,7 @@ private:
   _Node* _M_create_node(const value_type& __x) {
     _Node* __node = this->_M_get_node();
     __STL_TRY {
-      construct(&__node->_M_data, __x);
+      _Construct_scoped(&__node->_M_data, __x, get_allocator());
       __node->_M_next = 0;
     }
     __STL_UNWIND(this->_M_put_node(__node));
@@ -389,6 +389,10 @@ public:
   slist(const slist& __x) : _Base(__x.get_allocator())
     { _M_insert_after_range(&this->_M_head, __x.begin(), __x.end()); }
 
+  // A copy that allocates with __a; see _Construct_scoped.
+  slist(const slist& __x, const allocator_type& __a) : _Base(__a)
+    { _M_insert_after_range(&this->_M_head, __x.begin(), __x.end()); }
+
   slist& operator= (const slist& __x);
 
   ~slist() {}
@@ -834,6 +838,13 @@ inline void swap(slist<_Tp,_Alloc>& __x, slist<_Tp,_Alloc>& __y) {
 
 #endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
 
+#if defined(__STL_USE_STD_ALLOCATORS) && \
+    defined(__STL_CLASS_PARTIAL_SPECIALIZATION)
+template <class _Tp, class _Alloc, class _Outer>
+struct _Uses_allocator<slist<_Tp, _Alloc>, _Outer>
+  : public _Scoped_alloc_check<_Tp, _Alloc, _Outer> {};
+#endif
+
 
 template <class _Tp, class _Alloc>
 void slist<_Tp,_Alloc>::resize(size_type __len, const _Tp& __x)
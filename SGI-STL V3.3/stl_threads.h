@@ -206,6 +206,63 @@ struct _Refcount_Base
     }
 # endif
 
+// Lock-free LIFO list of nodes whose first word is the link to the next
+// node.  The head pointer is paired with a counter that every pop bumps,
+// and both are replaced by one double-width compare-and-swap, so a pop
+// that raced with a pop and re-push of the same node (the ABA problem)
+// fails and retries instead of installing a stale link.
+// A pop may read the link of a node that another thread has just taken
+// and is overwriting; the value is discarded when the swap fails.  So
+// nodes must stay mapped for as long as the list is in use.
+// Like _STL_mutex_lock this has no constructor; static instances start
+// out empty.
+#ifdef __STL_HAS_DOUBLE_WIDTH_CAS
+struct _STL_lock_free_stack
+{
+# ifdef __LP64__
+  typedef unsigned __int128 _Word;
+# else
+  typedef unsigned long long _Word;
+# endif
+  union _Head {
+    struct {
+      void* _M_ptr;
+      size_t _M_tag;
+    } _M_s;
+    _Word _M_word;
+  };
+
+  volatile _Word _M_head __attribute__((__aligned__(sizeof(_Word))));
+
+  // Pushes the chain __first ... __last, already linked together.
+  void _M_push(void* __first, void* __last) {
+    _Head __old, __new;
+    do {
+      // Two plain loads may see a torn head; the swap then fails.
+      __old._M_word = _M_head;
+      *(void**)__last = __old._M_s._M_ptr;
+      __new._M_s._M_ptr = __first;
+      __new._M_s._M_tag = __old._M_s._M_tag;
+    } while (!__sync_bool_compare_and_swap(&_M_head, __old._M_word,
+                                           __new._M_word));
+  }
+
+  // Returns 0 if the list is empty.
+  void* _M_pop() {
+    _Head __old, __new;
+    do {
+      __old._M_word = _M_head;
+      if (0 == __old._M_s._M_ptr)
+        return 0;
+      __new._M_s._M_ptr = *(void* volatile*)__old._M_s._M_ptr;
+      __new._M_s._M_tag = __old._M_s._M_tag + 1;
+    } while (!__sync_bool_compare_and_swap(&_M_head, __old._M_word,
+                                           __new._M_word));
+    return __old._M_s._M_ptr;
+  }
+};
+#endif /* __STL_HAS_DOUBLE_WIDTH_CAS */
+
 // Locking class.  Note that this class *does not have a constructor*.
 // It must be initialized either statically, with __STL_MUTEX_INITIALIZER,
 // or dynamically, by explicitly calling the _M_initialize member function.
@@ -296,6 +353,10 @@ struct _STL_mutex_lock
       _S_nsec_sleep(__log_nsec);
     }
   }
+  // Takes the lock only if it is free; answers whether it did.
+  bool _M_try_acquire_lock() {
+    return !_Atomic_swap((unsigned long*)&this->_M_lock, 1);
+  }
   void _M_release_lock() {
     volatile unsigned long* __lock = &_M_lock;
 #   if defined(__STL_SGI_THREADS) && defined(__GNUC__) && __mips >= 3
@@ -319,15 +380,18 @@ struct _STL_mutex_lock
   pthread_mutex_t _M_lock;
   void _M_initialize()   { pthread_mutex_init(&_M_lock, NULL); }
   void _M_acquire_lock() { pthread_mutex_lock(&_M_lock); }
+  bool _M_try_acquire_lock() { return 0 == pthread_mutex_trylock(&_M_lock); }
   void _M_release_lock() { pthread_mutex_unlock(&_M_lock); }
 #elif defined(__STL_UITHREADS)
   mutex_t _M_lock;
   void _M_initialize()   { mutex_init(&_M_lock, USYNC_THREAD, 0); }
   void _M_acquire_lock() { mutex_lock(&_M_lock); }
+  bool _M_try_acquire_lock() { return 0 == mutex_trylock(&_M_lock); }
   void _M_release_lock() { mutex_unlock(&_M_lock); }
 #else /* No threads */
   void _M_initialize()   {}
   void _M_acquire_lock() {}
+  bool _M_try_acquire_lock() { return true; }
   void _M_release_lock() {}
 #endif
 };
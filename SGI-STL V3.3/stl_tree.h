@@ -454,6 +454,14 @@ protected:
     { return _M_node_allocator.allocate(1); }
   void _M_put_node(_Rb_tree_node<_Tp>* __p) 
     { _M_node_allocator.deallocate(__p, 1); }
+  void _M_get_nodes(size_t __n, _Rb_tree_node<_Tp>** __out) {
+    size_t __i = 0;
+    __STL_TRY {
+      for ( ; __i < __n; ++__i)
+        __out[__i] = _M_node_allocator.allocate(1);
+    }
+    __STL_UNWIND(while (__i > 0) _M_node_allocator.deallocate(__out[--__i], 1));
+  }
 };
 
 // Specialization for instanceless allocators.
@@ -475,6 +483,8 @@ protected:
     { return _Alloc_type::allocate(1); }
   void _M_put_node(_Rb_tree_node<_Tp>* __p)
     { _Alloc_type::deallocate(__p, 1); }
+  void _M_get_nodes(size_t __n, _Rb_tree_node<_Tp>** __out)
+    { _Alloc_type::allocate_n_nodes(__n, __out); }
 };
 
 template <class _Tp, class _Alloc>
@@ -514,6 +524,8 @@ protected:
     { return _Alloc_type::allocate(1); }
   void _M_put_node(_Rb_tree_node<_Tp>* __p)
     { _Alloc_type::deallocate(__p, 1); }
+  void _M_get_nodes(size_t __n, _Rb_tree_node<_Tp>** __out)
+    { _Alloc_type::allocate_n_nodes(__n, __out); }
 };
 
 #endif /* __STL_USE_STD_ALLOCATORS */
@@ -544,6 +556,7 @@ protected:
 #ifdef __STL_USE_NAMESPACES
   using _Base::_M_get_node;
   using _Base::_M_put_node;
+  using _Base::_M_get_nodes;
   using _Base::_M_header;
 #endif /* __STL_USE_NAMESPACES */
 
@@ -553,7 +566,7 @@ protected:
   {
     _Link_type __tmp = _M_get_node();
     __STL_TRY {
-      construct(&__tmp->_M_value_field, __x);
+      _Construct_scoped(&__tmp->_M_value_field, __x, get_allocator());
     }
     __STL_UNWIND(_M_put_node(__tmp));
     return __tmp;
@@ -636,6 +649,14 @@ public:
 
 private:
   iterator _M_insert(_Base_ptr __x, _Base_ptr __y, const value_type& __v);
+  // Makes __z a child of __y, on the left if __left, and rebalances.
+  iterator _M_link_node(bool __left, _Link_type __y, _Link_type __z);
+  // Where a new element with key __k goes: under __y, on the left if
+  // the answer is true.
+  bool _M_equal_pos(const key_type& __k, _Link_type& __y);
+  // The same for unique keys.  Answers false, and sets __y to the
+  // element with an equal key, if there is one.
+  bool _M_unique_pos(const key_type& __k, _Link_type& __y, bool& __left);
   _Link_type _M_copy(_Link_type __x, _Link_type __p);
   void _M_erase(_Link_type __x);
 
@@ -656,17 +677,12 @@ public:
   _Rb_tree(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __x) 
     : _Base(__x.get_allocator()),
       _M_node_count(0), _M_key_compare(__x._M_key_compare)
-  { 
-    if (__x._M_root() == 0)
-      _M_empty_initialize();
-    else {
-      _S_color(_M_header) = _S_rb_tree_red;
-      _M_root() = _M_copy(__x._M_root(), _M_header);
-      _M_leftmost() = _S_minimum(_M_root());
-      _M_rightmost() = _S_maximum(_M_root());
-    }
-    _M_node_count = __x._M_node_count;
-  }
+    { _M_copy_initialize(__x); }
+  // A copy that allocates with __a; see _Construct_scoped.
+  _Rb_tree(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __x,
+           const allocator_type& __a)
+    : _Base(__a), _M_node_count(0), _M_key_compare(__x._M_key_compare)
+    { _M_copy_initialize(__x); }
   ~_Rb_tree() { clear(); }
   _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& 
   operator=(const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __x);
@@ -680,6 +696,19 @@ private:
     _M_rightmost() = _M_header;
   }
 
+  void _M_copy_initialize(
+    const _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>& __x) {
+    if (__x._M_root() == 0)
+      _M_empty_initialize();
+    else {
+      _S_color(_M_header) = _S_rb_tree_red;
+      _M_root() = _M_copy(__x._M_root(), _M_header);
+      _M_leftmost() = _S_minimum(_M_root());
+      _M_rightmost() = _S_maximum(_M_root());
+    }
+    _M_node_count = __x._M_node_count;
+  }
+
 public:    
                                 // accessors:
   _Compare key_comp() const { return _M_key_compare; }
@@ -715,9 +744,28 @@ public:
 
 #ifdef __STL_MEMBER_TEMPLATES  
   template <class _InputIterator>
-  void insert_unique(_InputIterator __first, _InputIterator __last);
+  void insert_unique(_InputIterator __first, _InputIterator __last) {
+    insert_unique(__first, __last, __ITERATOR_CATEGORY(__first));
+  }
   template <class _InputIterator>
-  void insert_equal(_InputIterator __first, _InputIterator __last);
+  void insert_equal(_InputIterator __first, _InputIterator __last) {
+    insert_equal(__first, __last, __ITERATOR_CATEGORY(__first));
+  }
+
+  template <class _InputIterator>
+  void insert_unique(_InputIterator __first, _InputIterator __last,
+                     input_iterator_tag);
+  template <class _InputIterator>
+  void insert_equal(_InputIterator __first, _InputIterator __last,
+                    input_iterator_tag);
+  // With the length known, the nodes come in batches.  A duplicate key
+  // does not use up a node.
+  template <class _ForwardIterator>
+  void insert_unique(_ForwardIterator __first, _ForwardIterator __last,
+                     forward_iterator_tag);
+  template <class _ForwardIterator>
+  void insert_equal(_ForwardIterator __first, _ForwardIterator __last,
+                    forward_iterator_tag);
 #else /* __STL_MEMBER_TEMPLATES */
   void insert_unique(const_iterator __first, const_iterator __last);
   void insert_unique(const value_type* __first, const value_type* __last);
@@ -857,11 +905,18 @@ _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>
 {
   _Link_type __x = (_Link_type) __x_;
   _Link_type __y = (_Link_type) __y_;
-  _Link_type __z;
+  bool __left = __y == _M_header || __x != 0 || 
+                _M_key_compare(_KeyOfValue()(__v), _S_key(__y));
+  return _M_link_node(__left, __y, _M_create_node(__v));
+}
 
-  if (__y == _M_header || __x != 0 || 
-      _M_key_compare(_KeyOfValue()(__v), _S_key(__y))) {
-    __z = _M_create_node(__v);
+template <class _Key, class _Value, class _KeyOfValue, 
+          class _Compare, class _Alloc>
+typename _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>::iterator
+_Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>
+  ::_M_link_node(bool __left, _Link_type __y, _Link_type __z)
+{
+  if (__left) {
     _S_left(__y) = __z;               // also makes _M_leftmost() = __z 
                                       //    when __y == _M_header
     if (__y == _M_header) {
@@ -872,7 +927,6 @@ _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>
       _M_leftmost() = __z;   // maintain _M_leftmost() pointing to min node
   }
   else {
-    __z = _M_create_node(__v);
     _S_right(__y) = __z;
     if (__y == _M_rightmost())
       _M_rightmost() = __z;  // maintain _M_rightmost() pointing to max node
@@ -887,45 +941,65 @@ _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>
 
 template <class _Key, class _Value, class _KeyOfValue, 
           class _Compare, class _Alloc>
-typename _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>::iterator
+bool
 _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>
-  ::insert_equal(const _Value& __v)
+  ::_M_equal_pos(const _Key& __k, _Link_type& __y)
 {
-  _Link_type __y = _M_header;
   _Link_type __x = _M_root();
+  bool __left = true;
+  __y = _M_header;
   while (__x != 0) {
     __y = __x;
-    __x = _M_key_compare(_KeyOfValue()(__v), _S_key(__x)) ? 
-            _S_left(__x) : _S_right(__x);
+    __left = _M_key_compare(__k, _S_key(__x));
+    __x = __left ? _S_left(__x) : _S_right(__x);
   }
-  return _M_insert(__x, __y, __v);
+  return __left;
 }
 
-
 template <class _Key, class _Value, class _KeyOfValue, 
           class _Compare, class _Alloc>
-pair<typename _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>::iterator, 
-     bool>
+bool
 _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>
-  ::insert_unique(const _Value& __v)
+  ::_M_unique_pos(const _Key& __k, _Link_type& __y, bool& __left)
 {
-  _Link_type __y = _M_header;
-  _Link_type __x = _M_root();
-  bool __comp = true;
-  while (__x != 0) {
-    __y = __x;
-    __comp = _M_key_compare(_KeyOfValue()(__v), _S_key(__x));
-    __x = __comp ? _S_left(__x) : _S_right(__x);
-  }
+  __left = _M_equal_pos(__k, __y);
   iterator __j = iterator(__y);   
-  if (__comp)
+  if (__left)
     if (__j == begin())     
-      return pair<iterator,bool>(_M_insert(__x, __y, __v), true);
+      return true;
     else
       --__j;
-  if (_M_key_compare(_S_key(__j._M_node), _KeyOfValue()(__v)))
-    return pair<iterator,bool>(_M_insert(__x, __y, __v), true);
-  return pair<iterator,bool>(__j, false);
+  if (_M_key_compare(_S_key(__j._M_node), __k))
+    return true;
+  __y = (_Link_type) __j._M_node;
+  return false;
+}
+
+template <class _Key, class _Value, class _KeyOfValue, 
+          class _Compare, class _Alloc>
+typename _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>::iterator
+_Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>
+  ::insert_equal(const _Value& __v)
+{
+  _Link_type __y;
+  bool __left = _M_equal_pos(_KeyOfValue()(__v), __y);
+  return _M_link_node(__left, __y, _M_create_node(__v));
+}
+
+
+template <class _Key, class _Value, class _KeyOfValue, 
+          class _Compare, class _Alloc>
+pair<typename _Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>::iterator, 
+     bool>
+_Rb_tree<_Key,_Value,_KeyOfValue,_Compare,_Alloc>
+  ::insert_unique(const _Value& __v)
+{
+  _Link_type __y;
+  bool __left;
+  if (_M_unique_pos(_KeyOfValue()(__v), __y, __left))
+    return pair<iterator,bool>(_M_link_node(__left, __y, _M_create_node(__v)),
+                               true);
+  return pair<iterator,bool>(iterator(__y), false);
 }
 
 
@@ -1000,7 +1074,7 @@ _Rb_tree<_Key,_Val,_KeyOfValue,_Compare,_Alloc>
 template <class _Key, class _Val, class _KoV, class _Cmp, class _Alloc>
   template<class _II>
 void _Rb_tree<_Key,_Val,_KoV,_Cmp,_Alloc>
-  ::insert_equal(_II __first, _II __last)
+  ::insert_equal(_II __first, _II __last, input_iterator_tag)
 {
   for ( ; __first != __last; ++__first)
     insert_equal(*__first);
@@ -1009,11 +1083,75 @@ void _Rb_tree<_Key,_Val,_KoV,_Cmp,_Alloc>
 template <class _Key, class _Val, class _KoV, class _Cmp, class _Alloc> 
   template<class _II>
 void _Rb_tree<_Key,_Val,_KoV,_Cmp,_Alloc>
-  ::insert_unique(_II __first, _II __last) {
+  ::insert_unique(_II __first, _II __last, input_iterator_tag) {
   for ( ; __first != __last; ++__first)
     insert_unique(*__first);
 }
 
+template <class _Key, class _Val, class _KoV, class _Cmp, class _Alloc>
+  template<class _FI>
+void _Rb_tree<_Key,_Val,_KoV,_Cmp,_Alloc>
+  ::insert_equal(_FI __first, _FI __last, forward_iterator_tag)
+{
+  size_type __n = 0;
+  distance(__first, __last, __n);
+  _Link_type __nodes[__stl_node_batch];
+  while (__n > 0) {
+    size_type __k = __n < (size_type) __stl_node_batch
+                      ? __n : (size_type) __stl_node_batch;
+    _M_get_nodes(__k, __nodes);
+    size_type __i = 0;
+    __STL_TRY {
+      for ( ; __i < __k; ++__i, ++__first) {
+        const _Val& __v = *__first;
+        _Link_type __y;
+        bool __left = _M_equal_pos(_KoV()(__v), __y);
+        _Construct_scoped(&__nodes[__i]->_M_value_field, __v,
+                          get_allocator());
+        _M_link_node(__left, __y, __nodes[__i]);
+      }
+    }
+    __STL_UNWIND(for ( ; __i < __k; ++__i) _M_put_node(__nodes[__i]));
+    __n -= __k;
+  }
+}
+
+template <class _Key, class _Val, class _KoV, class _Cmp, class _Alloc> 
+  template<class _FI>
+void _Rb_tree<_Key,_Val,_KoV,_Cmp,_Alloc>
+  ::insert_unique(_FI __first, _FI __last, forward_iterator_tag)
+{
+  size_type __n = 0;
+  distance(__first, __last, __n);
+  _Link_type __nodes[__stl_node_batch];
+  size_type __have = 0;
+  size_type __used = 0;
+  __STL_TRY {
+    for ( ; __n > 0; --__n, ++__first) {
+      const _Val& __v = *__first;
+      _Link_type __y;
+      bool __left;
+      if (!_M_unique_pos(_KoV()(__v), __y, __left))
+        continue;
+      if (__used == __have) {
+        // All used up, so there is nothing to give back if this throws.
+        size_type __k = __n < (size_type) __stl_node_batch
+                          ? __n : (size_type) __stl_node_batch;
+        _M_get_nodes(__k, __nodes);
+        __have = __k;
+        __used = 0;
+      }
+      _Construct_scoped(&__nodes[__used]->_M_value_field, __v,
+                        get_allocator());
+      _M_link_node(__left, __y, __nodes[__used++]);
+    }
+  }
+  __STL_UNWIND(while (__used < __have) _M_put_node(__nodes[__used++]));
+  // Left over by duplicates.
+  while (__used < __have)
+    _M_put_node(__nodes[__used++]);
+}
+
 #else /* __STL_MEMBER_TEMPLATES */
 
 template <class _Key, class _Val, class _KoV, class _Cmp, class _Alloc>
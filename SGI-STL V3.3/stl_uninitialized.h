@@ -277,6 +277,182 @@ __uninitialized_copy_fill(_InputIter __first1, _InputIter __last1,
   __STL_UNWIND(_Destroy(__first2, __mid2));
 }
 
+// Scoped versions, for containers that hand their allocator __a on to
+// the elements they copy in; see _Construct_scoped.  Elements that
+// cannot use __a go through the plain versions above.
+
+template <class _InputIter, class _ForwardIter, class _Alloc>
+inline _ForwardIter
+__uninitialized_copy_scoped_aux(_InputIter __first, _InputIter __last,
+                                _ForwardIter __result, const _Alloc&,
+                                __false_type)
+{
+  return uninitialized_copy(__first, __last, __result);
+}
+
+template <class _InputIter, class _ForwardIter, class _Alloc>
+_ForwardIter
+__uninitialized_copy_scoped_aux(_InputIter __first, _InputIter __last,
+                                _ForwardIter __result, const _Alloc& __a,
+                                __true_type)
+{
+  _ForwardIter __cur = __result;
+  __STL_TRY {
+    for ( ; __first != __last; ++__first, ++__cur)
+      _Construct_scoped(&*__cur, *__first, __a);
+    return __cur;
+  }
+  __STL_UNWIND(_Destroy(__result, __cur));
+}
+
+template <class _InputIter, class _ForwardIter, class _Alloc, class _Tp>
+inline _ForwardIter
+__uninitialized_copy_scoped(_InputIter __first, _InputIter __last,
+                            _ForwardIter __result, const _Alloc& __a, _Tp*)
+{
+  typedef typename _Uses_allocator<_Tp, _Alloc>::_Ret _Scoped;
+  return __uninitialized_copy_scoped_aux(__first, __last, __result, __a,
+                                         _Scoped());
+}
+
+template <class _InputIter, class _ForwardIter, class _Alloc>
+inline _ForwardIter
+_Uninitialized_copy_scoped(_InputIter __first, _InputIter __last,
+                           _ForwardIter __result, const _Alloc& __a)
+{
+  return __uninitialized_copy_scoped(__first, __last, __result, __a,
+                                     __VALUE_TYPE(__result));
+}
+
+template <class _ForwardIter, class _Tp, class _Alloc>
+inline void
+__uninitialized_fill_scoped_aux(_ForwardIter __first, _ForwardIter __last,
+                                const _Tp& __x, const _Alloc&, __false_type)
+{
+  uninitialized_fill(__first, __last, __x);
+}
+
+template <class _ForwardIter, class _Tp, class _Alloc>
+void
+__uninitialized_fill_scoped_aux(_ForwardIter __first, _ForwardIter __last,
+                                const _Tp& __x, const _Alloc& __a,
+                                __true_type)
+{
+  _ForwardIter __cur = __first;
+  __STL_TRY {
+    for ( ; __cur != __last; ++__cur)
+      _Construct_scoped(&*__cur, __x, __a);
+  }
+  __STL_UNWIND(_Destroy(__first, __cur));
+}
+
+template <class _ForwardIter, class _Tp, class _Alloc, class _Tp1>
+inline void
+__uninitialized_fill_scoped(_ForwardIter __first, _ForwardIter __last,
+                            const _Tp& __x, const _Alloc& __a, _Tp1*)
+{
+  typedef typename _Uses_allocator<_Tp1, _Alloc>::_Ret _Scoped;
+  __uninitialized_fill_scoped_aux(__first, __last, __x, __a, _Scoped());
+}
+
+template <class _ForwardIter, class _Tp, class _Alloc>
+inline void
+_Uninitialized_fill_scoped(_ForwardIter __first, _ForwardIter __last,
+                           const _Tp& __x, const _Alloc& __a)
+{
+  __uninitialized_fill_scoped(__first, __last, __x, __a,
+                              __VALUE_TYPE(__first));
+}
+
+template <class _ForwardIter, class _Size, class _Tp, class _Alloc>
+inline _ForwardIter
+__uninitialized_fill_n_scoped_aux(_ForwardIter __first, _Size __n,
+                                  const _Tp& __x, const _Alloc&,
+                                  __false_type)
+{
+  return uninitialized_fill_n(__first, __n, __x);
+}
+
+template <class _ForwardIter, class _Size, class _Tp, class _Alloc>
+_ForwardIter
+__uninitialized_fill_n_scoped_aux(_ForwardIter __first, _Size __n,
+                                  const _Tp& __x, const _Alloc& __a,
+                                  __true_type)
+{
+  _ForwardIter __cur = __first;
+  __STL_TRY {
+    for ( ; __n > 0; --__n, ++__cur)
+      _Construct_scoped(&*__cur, __x, __a);
+    return __cur;
+  }
+  __STL_UNWIND(_Destroy(__first, __cur));
+}
+
+template <class _ForwardIter, class _Size, class _Tp, class _Alloc,
+          class _Tp1>
+inline _ForwardIter
+__uninitialized_fill_n_scoped(_ForwardIter __first, _Size __n,
+                              const _Tp& __x, const _Alloc& __a, _Tp1*)
+{
+  typedef typename _Uses_allocator<_Tp1, _Alloc>::_Ret _Scoped;
+  return __uninitialized_fill_n_scoped_aux(__first, __n, __x, __a,
+                                           _Scoped());
+}
+
+template <class _ForwardIter, class _Size, class _Tp, class _Alloc>
+inline _ForwardIter
+_Uninitialized_fill_n_scoped(_ForwardIter __first, _Size __n,
+                             const _Tp& __x, const _Alloc& __a)
+{
+  return __uninitialized_fill_n_scoped(__first, __n, __x, __a,
+                                       __VALUE_TYPE(__first));
+}
+
+// The extensions above, scoped.
+
+template <class _InputIter1, class _InputIter2, class _ForwardIter,
+          class _Alloc>
+inline _ForwardIter
+__uninitialized_copy_copy(_InputIter1 __first1, _InputIter1 __last1,
+                          _InputIter2 __first2, _InputIter2 __last2,
+                          _ForwardIter __result, const _Alloc& __a)
+{
+  _ForwardIter __mid =
+    _Uninitialized_copy_scoped(__first1, __last1, __result, __a);
+  __STL_TRY {
+    return _Uninitialized_copy_scoped(__first2, __last2, __mid, __a);
+  }
+  __STL_UNWIND(_Destroy(__result, __mid));
+}
+
+template <class _ForwardIter, class _Tp, class _InputIter, class _Alloc>
+inline _ForwardIter 
+__uninitialized_fill_copy(_ForwardIter __result, _ForwardIter __mid,
+                          const _Tp& __x,
+                          _InputIter __first, _InputIter __last,
+                          const _Alloc& __a)
+{
+  _Uninitialized_fill_scoped(__result, __mid, __x, __a);
+  __STL_TRY {
+    return _Uninitialized_copy_scoped(__first, __last, __mid, __a);
+  }
+  __STL_UNWIND(_Destroy(__result, __mid));
+}
+
+template <class _InputIter, class _ForwardIter, class _Tp, class _Alloc>
+inline void
+__uninitialized_copy_fill(_InputIter __first1, _InputIter __last1,
+                          _ForwardIter __first2, _ForwardIter __last2,
+                          const _Tp& __x, const _Alloc& __a)
+{
+  _ForwardIter __mid2 =
+    _Uninitialized_copy_scoped(__first1, __last1, __first2, __a);
+  __STL_TRY {
+    _Uninitialized_fill_scoped(__mid2, __last2, __x, __a);
+  }
+  __STL_UNWIND(_Destroy(__first2, __mid2));
+}
+
 __STL_END_NAMESPACE
 
 #endif /* __SGI_STL_INTERNAL_UNINITIALIZED_H */
@@ -70,6 +70,11 @@ protected:
     { return _M_data_allocator.allocate(__n); }
   void _M_deallocate(_Tp* __p, size_t __n)
     { if (__p) _M_data_allocator.deallocate(__p, __n); }
+  // A general allocator need not support the extended protocol (see
+  // _Alloc_extensions in stl_alloc.h), so do without it.
+  _Tp* _M_allocate_at_least(size_t& __n)
+    { return _M_data_allocator.allocate(__n); }
+  bool _M_try_expand(_Tp*, size_t, size_t) { return false; }
 };
 
 // Specialization for allocators that have the property that we don't
@@ -95,6 +100,10 @@ protected:
     { return _Alloc_type::allocate(__n); }
   void _M_deallocate(_Tp* __p, size_t __n)
     { _Alloc_type::deallocate(__p, __n);}
+  _Tp* _M_allocate_at_least(size_t& __n)
+    { return _Alloc_type::allocate_at_least(__n, __n); }
+  bool _M_try_expand(_Tp* __p, size_t __old_n, size_t __new_n)
+    { return _Alloc_type::try_expand(__p, __old_n, __new_n); }
 };
 
 template <class _Tp, class _Alloc>
@@ -147,6 +156,13 @@ protected:
     { return _M_data_allocator::allocate(__n); }
   void _M_deallocate(_Tp* __p, size_t __n) 
     { _M_data_allocator::deallocate(__p, __n); }
+  // Allocates room for at least __n objects, and sets __n to the number
+  // there is actually room for.
+  _Tp* _M_allocate_at_least(size_t& __n)
+    { return _M_data_allocator::allocate_at_least(__n, __n); }
+  // Grows the block at __p in place, if the allocator can.
+  bool _M_try_expand(_Tp* __p, size_t __old_n, size_t __new_n)
+    { return _M_data_allocator::try_expand(__p, __old_n, __new_n); }
 };
 
 #endif /* __STL_USE_STD_ALLOCATORS */
@@ -188,6 +204,8 @@ protected:
 #ifdef __STL_HAS_NAMESPACES
   using _Base::_M_allocate;
   using _Base::_M_deallocate;
+  using _Base::_M_allocate_at_least;
+  using _Base::_M_try_expand;
   using _Base::_M_start;
   using _Base::_M_finish;
   using _Base::_M_end_of_storage;
@@ -197,6 +215,15 @@ protected:
   void _M_insert_aux(iterator __position, const _Tp& __x);
   void _M_insert_aux(iterator __position);
 
+  // Raises the capacity to __n without moving the elements, if the
+  // allocator can grow the block in place.
+  bool _M_expand_in_place(size_type __n) {
+    if (!_M_try_expand(_M_start, _M_end_of_storage - _M_start, __n))
+      return false;
+    _M_end_of_storage = _M_start + __n;
+    return true;
+  }
+
 public:
   iterator begin() { return _M_start; }
   const_iterator begin() const { return _M_start; }
@@ -242,15 +269,24 @@ public:
   vector(size_type __n, const _Tp& __value,
          const allocator_type& __a = allocator_type()) 
     : _Base(__n, __a)
-    { _M_finish = uninitialized_fill_n(_M_start, __n, __value); }
+    { _M_finish = _Uninitialized_fill_n_scoped(_M_start, __n, __value,
+                                               get_allocator()); }
 
   explicit vector(size_type __n)
     : _Base(__n, allocator_type())
-    { _M_finish = uninitialized_fill_n(_M_start, __n, _Tp()); }
+    { _M_finish = _Uninitialized_fill_n_scoped(_M_start, __n, _Tp(),
+                                               get_allocator()); }
 
   vector(const vector<_Tp, _Alloc>& __x) 
     : _Base(__x.size(), __x.get_allocator())
-    { _M_finish = uninitialized_copy(__x.begin(), __x.end(), _M_start); }
+    { _M_finish = _Uninitialized_copy_scoped(__x.begin(), __x.end(), _M_start,
+                                             get_allocator()); }
+
+  // A copy that allocates with __a; see _Construct_scoped.
+  vector(const vector<_Tp, _Alloc>& __x, const allocator_type& __a)
+    : _Base(__x.size(), __a)
+    { _M_finish = _Uninitialized_copy_scoped(__x.begin(), __x.end(), _M_start,
+                                             get_allocator()); }
 
 #ifdef __STL_MEMBER_TEMPLATES
   // Check whether it's an integral type.  If so, it's not an iterator.
@@ -265,7 +301,8 @@ public:
   void _M_initialize_aux(_Integer __n, _Integer __value, __true_type) {
     _M_start = _M_allocate(__n);
     _M_end_of_storage = _M_start + __n; 
-    _M_finish = uninitialized_fill_n(_M_start, __n, __value);
+    _M_finish = _Uninitialized_fill_n_scoped(_M_start, __n, __value,
+                                             get_allocator());
   }
 
   template <class _InputIterator>
@@ -278,14 +315,15 @@ public:
   vector(const _Tp* __first, const _Tp* __last,
          const allocator_type& __a = allocator_type())
     : _Base(__last - __first, __a) 
-    { _M_finish = uninitialized_copy(__first, __last, _M_start); }
+    { _M_finish = _Uninitialized_copy_scoped(__first, __last, _M_start,
+                                             get_allocator()); }
 #endif /* __STL_MEMBER_TEMPLATES */
 
   ~vector() { destroy(_M_start, _M_finish); }
 
   vector<_Tp, _Alloc>& operator=(const vector<_Tp, _Alloc>& __x);
   void reserve(size_type __n) {
-    if (capacity() < __n) {
+    if (capacity() < __n && !_M_expand_in_place(__n)) {
       const size_type __old_size = size();
       iterator __tmp = _M_allocate_and_copy(__n, _M_start, _M_finish);
       destroy(_M_start, _M_finish);
@@ -337,7 +375,7 @@ public:
 
   void push_back(const _Tp& __x) {
     if (_M_finish != _M_end_of_storage) {
-      construct(_M_finish, __x);
+      _Construct_scoped(_M_finish, __x, get_allocator());
       ++_M_finish;
     }
     else
@@ -360,7 +398,7 @@ public:
   iterator insert(iterator __position, const _Tp& __x) {
     size_type __n = __position - begin();
     if (_M_finish != _M_end_of_storage && __position == end()) {
-      construct(_M_finish, __x);
+      _Construct_scoped(_M_finish, __x, get_allocator());
       ++_M_finish;
     }
     else
@@ -442,7 +480,7 @@ protected:
 {
     iterator __result = _M_allocate(__n);
     __STL_TRY {
-      uninitialized_copy(__first, __last, __result);
+      _Uninitialized_copy_scoped(__first, __last, __result, get_allocator());
       return __result;
     }
     __STL_UNWIND(_M_deallocate(__result, __n));
@@ -453,7 +491,7 @@ protected:
   {
     iterator __result = _M_allocate(__n);
     __STL_TRY {
-      uninitialized_copy(__first, __last, __result);
+      _Uninitialized_copy_scoped(__first, __last, __result, get_allocator());
       return __result;
     }
     __STL_UNWIND(_M_deallocate(__result, __n));
@@ -479,7 +517,8 @@ protected:
     distance(__first, __last, __n);
     _M_start = _M_allocate(__n);
     _M_end_of_storage = _M_start + __n;
-    _M_finish = uninitialized_copy(__first, __last, _M_start);
+    _M_finish = _Uninitialized_copy_scoped(__first, __last, _M_start,
+                                           get_allocator());
   }
 
   template <class _InputIterator>
@@ -545,6 +584,13 @@ operator>=(const vector<_Tp, _Alloc>& __x, const vector<_Tp, _Alloc>& __y) {
 
 #endif /* __STL_FUNCTION_TMPL_PARTIAL_ORDER */
 
+#if defined(__STL_USE_STD_ALLOCATORS) && \
+    defined(__STL_CLASS_PARTIAL_SPECIALIZATION)
+template <class _Tp, class _Alloc, class _Outer>
+struct _Uses_allocator<vector<_Tp, _Alloc>, _Outer>
+  : public _Scoped_alloc_check<_Tp, _Alloc, _Outer> {};
+#endif
+
 template <class _Tp, class _Alloc>
 vector<_Tp,_Alloc>& 
 vector<_Tp,_Alloc>::operator=(const vector<_Tp, _Alloc>& __x)
@@ -564,7 +610,8 @@ vector<_Tp,_Alloc>::operator=(const vector<_Tp, _Alloc>& __x)
     }
     else {
       copy(__x.begin(), __x.begin() + size(), _M_start);
-      uninitialized_copy(__x.begin() + size(), __x.end(), _M_finish);
+      _Uninitialized_copy_scoped(__x.begin() + size(), __x.end(), _M_finish,
+                                 get_allocator());
     }
     _M_finish = _M_start + __xlen;
   }
@@ -580,7 +627,8 @@ void vector<_Tp, _Alloc>::_M_fill_assign(size_t __n, const value_type& __val)
   }
   else if (__n > size()) {
     fill(begin(), end(), __val);
-    _M_finish = uninitialized_fill_n(_M_finish, __n - size(), __val);
+    _M_finish = _Uninitialized_fill_n_scoped(_M_finish, __n - size(), __val,
+                                             get_allocator());
   }
   else
     erase(fill_n(begin(), __n, __val), end());
@@ -623,7 +671,8 @@ vector<_Tp, _Alloc>::_M_assign_aux(_ForwardIter __first, _ForwardIter __last,
     _ForwardIter __mid = __first;
     advance(__mid, size());
     copy(__first, __mid, _M_start);
-    _M_finish = uninitialized_copy(__mid, __last, _M_finish);
+    _M_finish = _Uninitialized_copy_scoped(__mid, __last, _M_finish,
+                                           get_allocator());
   }
 }
 
@@ -633,23 +682,33 @@ template <class _Tp, class _Alloc>
 void 
 vector<_Tp, _Alloc>::_M_insert_aux(iterator __position, const _Tp& __x)
 {
+  if (_M_finish == _M_end_of_storage)
+    _M_expand_in_place(size() != 0 ? 2 * size() : 1);
   if (_M_finish != _M_end_of_storage) {
-    construct(_M_finish, *(_M_finish - 1));
-    ++_M_finish;
-    _Tp __x_copy = __x;
-    copy_backward(__position, _M_finish - 2, _M_finish - 1);
-    *__position = __x_copy;
+    if (__position == _M_finish) {      // Only after growing in place.
+      _Construct_scoped(_M_finish, __x, get_allocator());
+      ++_M_finish;
+    }
+    else {
+      _Construct_scoped(_M_finish, *(_M_finish - 1), get_allocator());
+      ++_M_finish;
+      _Tp __x_copy = __x;
+      copy_backward(__position, _M_finish - 2, _M_finish - 1);
+      *__position = __x_copy;
+    }
   }
   else {
     const size_type __old_size = size();
-    const size_type __len = __old_size != 0 ? 2 * __old_size : 1;
-    iterator __new_start = _M_allocate(__len);
+    size_type __len = __old_size != 0 ? 2 * __old_size : 1;
+    iterator __new_start = _M_allocate_at_least(__len);
     iterator __new_finish = __new_start;
     __STL_TRY {
-      __new_finish = uninitialized_copy(_M_start, __position, __new_start);
-      construct(__new_finish, __x);
+      __new_finish = _Uninitialized_copy_scoped(_M_start, __position,
+                                                __new_start, get_allocator());
+      _Construct_scoped(__new_finish, __x, get_allocator());
       ++__new_finish;
-      __new_finish = uninitialized_copy(__position, _M_finish, __new_finish);
+      __new_finish = _Uninitialized_copy_scoped(__position, _M_finish,
+                                                __new_finish, get_allocator());
     }
     __STL_UNWIND((destroy(__new_start,__new_finish), 
                   _M_deallocate(__new_start,__len)));
@@ -665,22 +724,32 @@ template <class _Tp, class _Alloc>
 void 
 vector<_Tp, _Alloc>::_M_insert_aux(iterator __position)
 {
+  if (_M_finish == _M_end_of_storage)
+    _M_expand_in_place(size() != 0 ? 2 * size() : 1);
   if (_M_finish != _M_end_of_storage) {
-    construct(_M_finish, *(_M_finish - 1));
-    ++_M_finish;
-    copy_backward(__position, _M_finish - 2, _M_finish - 1);
-    *__position = _Tp();
+    if (__position == _M_finish) {      // Only after growing in place.
+      construct(_M_finish);
+      ++_M_finish;
+    }
+    else {
+      _Construct_scoped(_M_finish, *(_M_finish - 1), get_allocator());
+      ++_M_finish;
+      copy_backward(__position, _M_finish - 2, _M_finish - 1);
+      *__position = _Tp();
+    }
   }
   else {
     const size_type __old_size = size();
-    const size_type __len = __old_size != 0 ? 2 * __old_size : 1;
-    iterator __new_start = _M_allocate(__len);
+    size_type __len = __old_size != 0 ? 2 * __old_size : 1;
+    iterator __new_start = _M_allocate_at_least(__len);
     iterator __new_finish = __new_start;
     __STL_TRY {
-      __new_finish = uninitialized_copy(_M_start, __position, __new_start);
+      __new_finish = _Uninitialized_copy_scoped(_M_start, __position,
+                                                __new_start, get_allocator());
       construct(__new_finish);
       ++__new_finish;
-      __new_finish = uninitialized_copy(__position, _M_finish, __new_finish);
+      __new_finish = _Uninitialized_copy_scoped(__position, _M_finish,
+                                                __new_finish, get_allocator());
     }
     __STL_UNWIND((destroy(__new_start,__new_finish), 
                   _M_deallocate(__new_start,__len)));
@@ -697,34 +766,42 @@ void vector<_Tp, _Alloc>::_M_fill_insert(iterator __position, size_type __n,
                                          const _Tp& __x)
 {
   if (__n != 0) {
+    if (size_type(_M_end_of_storage - _M_finish) < __n)
+      _M_expand_in_place(size() + max(size(), __n));
     if (size_type(_M_end_of_storage - _M_finish) >= __n) {
       _Tp __x_copy = __x;
       const size_type __elems_after = _M_finish - __position;
       iterator __old_finish = _M_finish;
       if (__elems_after > __n) {
-        uninitialized_copy(_M_finish - __n, _M_finish, _M_finish);
+        _Uninitialized_copy_scoped(_M_finish - __n, _M_finish, _M_finish,
+                                   get_allocator());
         _M_finish += __n;
         copy_backward(__position, __old_finish - __n, __old_finish);
         fill(__position, __position + __n, __x_copy);
       }
       else {
-        uninitialized_fill_n(_M_finish, __n - __elems_after, __x_copy);
+        _Uninitialized_fill_n_scoped(_M_finish, __n - __elems_after, __x_copy,
+                                     get_allocator());
         _M_finish += __n - __elems_after;
-        uninitialized_copy(__position, __old_finish, _M_finish);
+        _Uninitialized_copy_scoped(__position, __old_finish, _M_finish,
+                                   get_allocator());
         _M_finish += __elems_after;
         fill(__position, __old_finish, __x_copy);
       }
     }
     else {
       const size_type __old_size = size();        
-      const size_type __len = __old_size + max(__old_size, __n);
-      iterator __new_start = _M_allocate(__len);
+      size_type __len = __old_size + max(__old_size, __n);
+      iterator __new_start = _M_allocate_at_least(__len);
       iterator __new_finish = __new_start;
       __STL_TRY {
-        __new_finish = uninitialized_copy(_M_start, __position, __new_start);
-        __new_finish = uninitialized_fill_n(__new_finish, __n, __x);
+        __new_finish = _Uninitialized_copy_scoped(_M_start, __position,
+                                                  __new_start, get_allocator());
+        __new_finish = _Uninitialized_fill_n_scoped(__new_finish, __n, __x,
+                                                    get_allocator());
         __new_finish
-          = uninitialized_copy(__position, _M_finish, __new_finish);
+          = _Uninitialized_copy_scoped(__position, _M_finish, __new_finish,
+                                       get_allocator());
       }
       __STL_UNWIND((destroy(__new_start,__new_finish), 
                     _M_deallocate(__new_start,__len)));
@@ -762,11 +839,14 @@ vector<_Tp, _Alloc>::_M_range_insert(iterator __position,
   if (__first != __last) {
     size_type __n = 0;
     distance(__first, __last, __n);
+    if (size_type(_M_end_of_storage - _M_finish) < __n)
+      _M_expand_in_place(size() + max(size(), __n));
     if (size_type(_M_end_of_storage - _M_finish) >= __n) {
       const size_type __elems_after = _M_finish - __position;
       iterator __old_finish = _M_finish;
       if (__elems_after > __n) {
-        uninitialized_copy(_M_finish - __n, _M_finish, _M_finish);
+        _Uninitialized_copy_scoped(_M_finish - __n, _M_finish, _M_finish,
+                                   get_allocator());
         _M_finish += __n;
         copy_backward(__position, __old_finish - __n, __old_finish);
         copy(__first, __last, __position);
@@ -774,23 +854,27 @@ vector<_Tp, _Alloc>::_M_range_insert(iterator __position,
       else {
         _ForwardIterator __mid = __first;
         advance(__mid, __elems_after);
-        uninitialized_copy(__mid, __last, _M_finish);
+        _Uninitialized_copy_scoped(__mid, __last, _M_finish, get_allocator());
         _M_finish += __n - __elems_after;
-        uninitialized_copy(__position, __old_finish, _M_finish);
+        _Uninitialized_copy_scoped(__position, __old_finish, _M_finish,
+                                   get_allocator());
         _M_finish += __elems_after;
         copy(__first, __mid, __position);
       }
     }
     else {
       const size_type __old_size = size();
-      const size_type __len = __old_size + max(__old_size, __n);
-      iterator __new_start = _M_allocate(__len);
+      size_type __len = __old_size + max(__old_size, __n);
+      iterator __new_start = _M_allocate_at_least(__len);
       iterator __new_finish = __new_start;
       __STL_TRY {
-        __new_finish = uninitialized_copy(_M_start, __position, __new_start);
-        __new_finish = uninitialized_copy(__first, __last, __new_finish);
+        __new_finish = _Uninitialized_copy_scoped(_M_start, __position,
+                                                  __new_start, get_allocator());
+        __new_finish = _Uninitialized_copy_scoped(__first, __last, __new_finish,
+                                                  get_allocator());
         __new_finish
-          = uninitialized_copy(__position, _M_finish, __new_finish);
+          = _Uninitialized_copy_scoped(__position, _M_finish, __new_finish,
+                                       get_allocator());
       }
       __STL_UNWIND((destroy(__new_start,__new_finish), 
                     _M_deallocate(__new_start,__len)));
@@ -814,33 +898,41 @@ vector<_Tp, _Alloc>::insert(iterator __position,
   if (__first != __last) {
     size_type __n = 0;
     distance(__first, __last, __n);
+    if (size_type(_M_end_of_storage - _M_finish) < __n)
+      _M_expand_in_place(size() + max(size(), __n));
     if (size_type(_M_end_of_storage - _M_finish) >= __n) {
       const size_type __elems_after = _M_finish - __position;
       iterator __old_finish = _M_finish;
       if (__elems_after > __n) {
-        uninitialized_copy(_M_finish - __n, _M_finish, _M_finish);
+        _Uninitialized_copy_scoped(_M_finish - __n, _M_finish, _M_finish,
+                                   get_allocator());
         _M_finish += __n;
         copy_backward(__position, __old_finish - __n, __old_finish);
         copy(__first, __last, __position);
       }
       else {
-        uninitialized_copy(__first + __elems_after, __last, _M_finish);
+        _Uninitialized_copy_scoped(__first + __elems_after, __last, _M_finish,
+                                   get_allocator());
         _M_finish += __n - __elems_after;
-        uninitialized_copy(__position, __old_finish, _M_finish);
+        _Uninitialized_copy_scoped(__position, __old_finish, _M_finish,
+                                   get_allocator());
         _M_finish += __elems_after;
         copy(__first, __first + __elems_after, __position);
       }
     }
     else {
       const size_type __old_size = size();
-      const size_type __len = __old_size + max(__old_size, __n);
-      iterator __new_start = _M_allocate(__len);
+      size_type __len = __old_size + max(__old_size, __n);
+      iterator __new_start = _M_allocate_at_least(__len);
       iterator __new_finish = __new_start;
       __STL_TRY {
-        __new_finish = uninitialized_copy(_M_start, __position, __new_start);
-        __new_finish = uninitialized_copy(__first, __last, __new_finish);
+        __new_finish = _Uninitialized_copy_scoped(_M_start, __position,
+                                                  __new_start, get_allocator());
+        __new_finish = _Uninitialized_copy_scoped(__first, __last, __new_finish,
+                                                  get_allocator());
         __new_finish
-          = uninitialized_copy(__position, _M_finish, __new_finish);
+          = _Uninitialized_copy_scoped(__position, _M_finish, __new_finish,
+                                       get_allocator());
       }
       __STL_UNWIND((destroy(__new_start,__new_finish),
                     _M_deallocate(__new_start,__len)));